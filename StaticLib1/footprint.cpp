@@ -0,0 +1,147 @@
+// Need the following as the first include for a Visual Studio environment
+#include "stdafx.h"
+
+/*
+Process wide counters of footprint.h.
+*/
+#include "footprint.h"
+
+#include <atomic>
+#include <iomanip>
+#include <ostream>
+
+namespace footprint
+{
+	namespace
+	{
+		struct Counters
+		{
+			std::atomic<std::size_t> live{ 0 };
+			std::atomic<std::size_t> peak{ 0 };
+			std::atomic<std::size_t> allocations{ 0 };
+			std::atomic<std::size_t> overhead{ 0 };
+		};
+
+		struct State
+		{
+			Counters components[componentCount];
+			Counters total;
+			std::atomic<std::size_t> graphCopies{ 0 };
+		};
+
+		State& state()
+		{
+			static State s;
+			return s;
+		}
+
+		void raisePeak(std::atomic<std::size_t>& peak, std::size_t live)
+		{
+			std::size_t p = peak.load(std::memory_order_relaxed);
+			while (live > p && !peak.compare_exchange_weak(p, live, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		void add(Counters& c, std::size_t bytes, std::size_t overhead)
+		{
+			std::size_t live = c.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+			c.allocations.fetch_add(1, std::memory_order_relaxed);
+			c.overhead.fetch_add(overhead, std::memory_order_relaxed);
+			raisePeak(c.peak, live);
+		}
+
+		void subtract(Counters& c, std::size_t bytes, std::size_t overhead)
+		{
+			c.live.fetch_sub(bytes, std::memory_order_relaxed);
+			c.overhead.fetch_sub(overhead, std::memory_order_relaxed);
+		}
+
+		Usage read(const Counters& c)
+		{
+			Usage u;
+			u.live = c.live.load(std::memory_order_relaxed);
+			u.peak = c.peak.load(std::memory_order_relaxed);
+			u.allocations = c.allocations.load(std::memory_order_relaxed);
+			u.overhead = c.overhead.load(std::memory_order_relaxed);
+			return u;
+		}
+	}
+
+	const char* componentName(Component c)
+	{
+		switch (c)
+		{
+		case Component::Graph:
+			return "graph";
+		case Component::Solver:
+			return "solver";
+		case Component::Cache:
+			return "cache";
+		default:
+			return "other";
+		}
+	}
+
+	void allocated(Component c, std::size_t bytes, std::size_t overhead)
+	{
+		State& s = state();
+		add(s.components[static_cast<int>(c)], bytes, overhead);
+		add(s.total, bytes, overhead);
+	}
+
+	void released(Component c, std::size_t bytes, std::size_t overhead)
+	{
+		State& s = state();
+		subtract(s.components[static_cast<int>(c)], bytes, overhead);
+		subtract(s.total, bytes, overhead);
+	}
+
+	Usage usage(Component c)
+	{
+		return read(state().components[static_cast<int>(c)]);
+	}
+
+	Usage total()
+	{
+		return read(state().total);
+	}
+
+	std::size_t graphCopies()
+	{
+		return state().graphCopies.load(std::memory_order_relaxed);
+	}
+
+	void countGraphCopy()
+	{
+		state().graphCopies.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void resetPeaks()
+	{
+		State& s = state();
+		for (auto& c : s.components)
+		{
+			c.peak.store(c.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+		s.total.peak.store(s.total.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+
+	void report(std::ostream& out)
+	{
+		out << "Memory (bytes)" << std::setw(14) << "live" << std::setw(14) << "peak";
+		out << std::setw(14) << "allocations" << std::setw(14) << "overhead" << '\n';
+		auto line = [&out](const char* name, const Usage& u)
+		{
+			out << "  " << std::left << std::setw(12) << name << std::right;
+			out << std::setw(14) << u.live << std::setw(14) << u.peak;
+			out << std::setw(14) << u.allocations << std::setw(14) << u.overhead << '\n';
+		};
+		for (int c = 0; c < componentCount; ++c)
+		{
+			line(componentName(static_cast<Component>(c)), usage(static_cast<Component>(c)));
+		}
+		line("total", total());
+		out << "  graph copies: " << graphCopies() << '\n';
+	}
+}
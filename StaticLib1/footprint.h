@@ -0,0 +1,112 @@
+/*
+Memory accounting for graphs, solvers and caches.
+
+Every tracked allocation is charged to a component; for each component
+the live bytes, the peak live bytes and the allocation count are kept,
+plus the peak of the sum over all components.  Only allocations and
+frees update the counters (atomics, no locks), never element access.
+
+What is tracked:
+	- Matrix blocks (matrix.h), charged to Graph unless the matrix is
+	  created for another component; the row padding that aligns every
+	  row is reported separately as overhead
+	- containers declared with footprint::Vector / footprint::Allocator,
+	  e.g. the CSR arena of the dijkstra.h Graph (Graph), the solver
+	  distance, visited and queue arrays (Solver) and the PathCache index
+	  (Cache)
+	- copies of a graph object, counted by a GraphCopies member
+
+	footprint::report(std::cout);
+	std::size_t peak = footprint::usage(footprint::Component::Solver).peak;
+*/
+#pragma once
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <vector>
+
+namespace footprint
+{
+	enum class Component
+	{
+		Graph,
+		Solver,
+		Cache,
+		Other
+	};
+	const int componentCount = 4;
+
+	const char* componentName(Component c);
+
+	struct Usage
+	{
+		std::size_t live = 0;
+		std::size_t peak = 0;
+		std::size_t allocations = 0;
+		// Live bytes allocated but holding no data (row padding)
+		std::size_t overhead = 0;
+	};
+
+	void allocated(Component c, std::size_t bytes, std::size_t overhead = 0);
+	void released(Component c, std::size_t bytes, std::size_t overhead = 0);
+
+	Usage usage(Component c);
+	// Sum over the components; peak is the peak of the sum
+	Usage total();
+	// Copies made of graph objects so far
+	std::size_t graphCopies();
+	void countGraphCopy();
+	// Start the peaks again from the current live bytes
+	void resetPeaks();
+
+	// A table of the above
+	void report(std::ostream& out);
+
+	// Standard allocator charging component C
+	template <class T, Component C>
+	class Allocator
+	{
+	public:
+		using value_type = T;
+		template <class U>
+		struct rebind
+		{
+			using other = Allocator<U, C>;
+		};
+
+		Allocator() noexcept {};
+		template <class U>
+		Allocator(const Allocator<U, C>&) noexcept {};
+
+		T* allocate(std::size_t n)
+		{
+			T* p = std::allocator<T>().allocate(n);
+			allocated(C, n * sizeof(T));
+			return p;
+		}
+		void deallocate(T* p, std::size_t n) noexcept
+		{
+			released(C, n * sizeof(T));
+			std::allocator<T>().deallocate(p, n);
+		}
+
+		template <class U>
+		bool operator==(const Allocator<U, C>&) const noexcept { return true; };
+		template <class U>
+		bool operator!=(const Allocator<U, C>&) const noexcept { return false; };
+	};
+
+	template <class T, Component C>
+	using Vector = std::vector<T, Allocator<T, C>>;
+
+	// Member of a graph class: counts the copies of its owner, not moves
+	class GraphCopies
+	{
+	public:
+		GraphCopies() {};
+		GraphCopies(const GraphCopies&) { countGraphCopy(); };
+		GraphCopies(GraphCopies&&) noexcept {};
+		GraphCopies& operator=(const GraphCopies&) { countGraphCopy(); return *this; };
+		GraphCopies& operator=(GraphCopies&&) noexcept { return *this; };
+	};
+}
@@ -0,0 +1,223 @@
+/*
+Synthetic graph generators for scaling benchmarks.
+
+The uniform random matrices of Graph::generate have neither the degree
+distribution nor the diameter of real graphs.  These generators model
+the common families:
+
+	grid          - rows x cols lattice with two way edges between
+	                neighbours, some dropped at random: road like, degree
+	                at most 4, diameter about rows + cols
+	geometric     - random geometric graph: points uniform in the unit
+	                square, two way edges between points closer than the
+	                radius giving the requested mean degree, cost growing
+	                with the distance; large diameter, local structure
+	rmat          - R-MAT (Kronecker) graph of 2^scale vertices: each edge
+	                picks a quadrant of the adjacency matrix per level with
+	                probabilities a, b, c, d (Graph500 defaults); power law
+	                degrees and a small diameter.  The ids are shuffled so
+	                the hubs are not all at low ids.
+	barabasiAlbert - preferential attachment: each new vertex links to m
+	                distinct earlier vertices chosen in proportion to
+	                their degree; power law degrees, two way edges
+
+Each generator streams its edges once, in no particular order, to a sink
+called as sink(src, dst, cost): an edge list for Graph::build, a
+graph::Graph, or an EdgeWriter (graph_io.h) to go straight to disk.  No
+generator keeps the edges: the memory is O(V), plus the 2 m V endpoint
+list of barabasiAlbert, so 10^8 edge graphs can be written on any box.
+rmat may produce self loops and duplicate edges, which Graph::build
+drops.  Costs are uniform in [minCost, maxCost] unless stated.
+
+	RandomStream rng(seed);
+	std::vector<Edge> edges;
+	generators::rmat(20, 16, rng, [&](int s, int d, int c) { edges.push_back(Edge(s, d, c)); });
+*/
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "random.h"
+
+namespace generators
+{
+	// Vertex count of each generator for the given parameters
+	inline long long gridVertices(int rows, int cols) { return static_cast<long long>(rows) * cols; };
+	inline long long rmatVertices(int scale) { return 1ll << scale; };
+
+	template <class Sink>
+	void grid(int rows, int cols, RandomStream& rng, Sink sink, double keep = 0.9,
+		int minCost = 1, int maxCost = 10)
+	{
+		for (int r = 0; r < rows; ++r)
+		{
+			for (int c = 0; c < cols; ++c)
+			{
+				int v = r * cols + c;
+				// Right and down neighbours; each road goes both ways
+				if (c + 1 < cols && rng.uniform(0.0, 1.0) < keep)
+				{
+					int cost = rng.uniform(minCost, maxCost);
+					sink(v, v + 1, cost);
+					sink(v + 1, v, cost);
+				}
+				if (r + 1 < rows && rng.uniform(0.0, 1.0) < keep)
+				{
+					int cost = rng.uniform(minCost, maxCost);
+					sink(v, v + cols, cost);
+					sink(v + cols, v, cost);
+				}
+			}
+		}
+	}
+
+	// The points are bucketed in cells of the radius' size, so only the
+	// 3 x 3 cells around a point are searched: O(V + E).  The cost is the
+	// distance scaled to [1, maxCost].
+	template <class Sink>
+	void geometric(int n, double degree, RandomStream& rng, Sink sink, int maxCost = 10)
+	{
+		if (n <= 1)
+		{
+			return;
+		}
+		const double pi = 3.14159265358979323846;
+		double radius = std::min(1.0, std::sqrt(degree / (pi * n)));
+		int cells = std::max(1, std::min(static_cast<int>(1.0 / radius), static_cast<int>(std::sqrt(static_cast<double>(n)))));
+		std::vector<double> x(n);
+		std::vector<double> y(n);
+		rng.fill(x.data(), x.size(), 0.0, 1.0);
+		rng.fill(y.data(), y.size(), 0.0, 1.0);
+
+		auto cellOf = [cells](double p)
+		{
+			return std::min(cells - 1, static_cast<int>(p * cells));
+		};
+		// Points sorted by cell, counting sort
+		std::vector<int> start(static_cast<std::size_t>(cells) * cells + 1, 0);
+		for (int i = 0; i < n; ++i)
+		{
+			++start[static_cast<std::size_t>(cellOf(y[i])) * cells + cellOf(x[i]) + 1];
+		}
+		std::partial_sum(start.begin(), start.end(), start.begin());
+		std::vector<int> points(n);
+		std::vector<int> next(start.begin(), start.end() - 1);
+		for (int i = 0; i < n; ++i)
+		{
+			points[next[static_cast<std::size_t>(cellOf(y[i])) * cells + cellOf(x[i])]++] = i;
+		}
+
+		double r2 = radius * radius;
+		for (int i = 0; i < n; ++i)
+		{
+			int cx = cellOf(x[i]);
+			int cy = cellOf(y[i]);
+			for (int ny = std::max(0, cy - 1); ny <= std::min(cells - 1, cy + 1); ++ny)
+			{
+				for (int nx = std::max(0, cx - 1); nx <= std::min(cells - 1, cx + 1); ++nx)
+				{
+					std::size_t cell = static_cast<std::size_t>(ny) * cells + nx;
+					for (int k = start[cell]; k < start[cell + 1]; ++k)
+					{
+						int j = points[k];
+						double dx = x[i] - x[j];
+						double dy = y[i] - y[j];
+						double d2 = dx * dx + dy * dy;
+						// Each pair once, from its lower id
+						if (j > i && d2 < r2)
+						{
+							int cost = std::max(1, static_cast<int>(std::ceil(std::sqrt(d2) / radius * maxCost)));
+							sink(i, j, cost);
+							sink(j, i, cost);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// edgeFactor edges per vertex
+	template <class Sink>
+	void rmat(int scale, int edgeFactor, RandomStream& rng, Sink sink,
+		double a = 0.57, double b = 0.19, double c = 0.19, int minCost = 1, int maxCost = 10)
+	{
+		int n = 1 << scale;
+		std::vector<int> ids(n);
+		std::iota(ids.begin(), ids.end(), 0);
+		for (int i = n - 1; i > 0; --i)
+		{
+			std::swap(ids[i], ids[rng.uniform(0, i)]);
+		}
+		long long edges = static_cast<long long>(edgeFactor) * n;
+		for (long long e = 0; e < edges; ++e)
+		{
+			int src = 0;
+			int dst = 0;
+			for (int bit = scale - 1; bit >= 0; --bit)
+			{
+				double p = rng.uniform(0.0, 1.0);
+				if (p >= a + b + c)
+				{
+					src |= 1 << bit;
+					dst |= 1 << bit;
+				}
+				else if (p >= a + b)
+				{
+					src |= 1 << bit;
+				}
+				else if (p >= a)
+				{
+					dst |= 1 << bit;
+				}
+			}
+			sink(ids[src], ids[dst], rng.uniform(minCost, maxCost));
+		}
+	}
+
+	// Starts from a clique of m + 1 vertices.  Every edge end is kept in a
+	// list, so drawing a list entry picks a vertex in proportion to its
+	// degree.
+	template <class Sink>
+	void barabasiAlbert(int n, int m, RandomStream& rng, Sink sink, int minCost = 1, int maxCost = 10)
+	{
+		m = std::max(1, m);
+		int seed = std::min(n, m + 1);
+		std::vector<int> ends;
+		ends.reserve(2 * static_cast<std::size_t>(m) * n);
+		for (int i = 0; i < seed; ++i)
+		{
+			for (int j = i + 1; j < seed; ++j)
+			{
+				int cost = rng.uniform(minCost, maxCost);
+				sink(i, j, cost);
+				sink(j, i, cost);
+				ends.push_back(i);
+				ends.push_back(j);
+			}
+		}
+		std::vector<int> chosen;
+		for (int v = seed; v < n; ++v)
+		{
+			chosen.clear();
+			while (static_cast<int>(chosen.size()) < m)
+			{
+				int t = ends[rng.uniform(0, static_cast<int>(ends.size()) - 1)];
+				if (std::find(chosen.begin(), chosen.end(), t) == chosen.end())
+				{
+					chosen.push_back(t);
+				}
+			}
+			for (int t : chosen)
+			{
+				int cost = rng.uniform(minCost, maxCost);
+				sink(v, t, cost);
+				sink(t, v, cost);
+				ends.push_back(v);
+				ends.push_back(t);
+			}
+		}
+	}
+}
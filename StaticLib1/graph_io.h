@@ -0,0 +1,219 @@
+/*
+Graph and result output.
+
+The matrix dumps used to write every one of the V x V cells through
+operator<< and flush with std::endl on each row, so for large graphs the
+output took longer than the algorithm.  Output now goes through a
+BufferedWriter: a large buffer, integers formatted with std::to_chars and
+a single write to the stream when the buffer fills.
+
+Formats:
+	Matrix - the V x V matrix, one row per line (the original layout)
+	Sparse - "size" then one "i j c" line per edge; the same format as the
+	         mst data files, so a dump can be read back by Graph::populate()
+	Binary - "GRPH", int32 size, then int32 (i, j, c) records to the end
+	None   - nothing; for timing runs
+*/
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+enum class OutputFormat
+{
+	Matrix,
+	Sparse,
+	Binary,
+	None
+};
+
+inline OutputFormat parseOutputFormat(const std::string& name)
+{
+	if (name == "sparse")
+	{
+		return OutputFormat::Sparse;
+	}
+	if (name == "binary")
+	{
+		return OutputFormat::Binary;
+	}
+	if (name == "none")
+	{
+		return OutputFormat::None;
+	}
+	return OutputFormat::Matrix;
+}
+
+// Buffered writer over an ostream; flushes to the stream only when the
+// buffer is full or on destruction.
+class BufferedWriter
+{
+private:
+	std::ostream& m_out;
+	std::vector<char> m_buffer;
+	std::size_t m_used;
+
+	void reserve(std::size_t n)
+	{
+		if (m_used + n > m_buffer.size())
+		{
+			flush();
+		}
+	}
+
+public:
+	explicit BufferedWriter(std::ostream& out, std::size_t size = 1 << 20)
+		: m_out(out), m_buffer(size), m_used(0)
+	{};
+	~BufferedWriter() { flush(); };
+	BufferedWriter(const BufferedWriter&) = delete;
+	BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+	void flush()
+	{
+		m_out.write(m_buffer.data(), m_used);
+		m_used = 0;
+	}
+
+	BufferedWriter& put(long long value)
+	{
+		// Enough for any 64 bit value and its sign
+		reserve(24);
+		auto result = std::to_chars(&m_buffer[m_used], &m_buffer[0] + m_buffer.size(), value);
+		m_used = result.ptr - m_buffer.data();
+		return *this;
+	}
+
+	BufferedWriter& put(char c)
+	{
+		reserve(1);
+		m_buffer[m_used++] = c;
+		return *this;
+	}
+
+	BufferedWriter& put(const char* s)
+	{
+		return write(s, std::strlen(s));
+	}
+
+	BufferedWriter& write(const void* data, std::size_t n)
+	{
+		if (n > m_buffer.size())
+		{
+			flush();
+			m_out.write(static_cast<const char*>(data), n);
+			return *this;
+		}
+		reserve(n);
+		std::memcpy(&m_buffer[m_used], data, n);
+		m_used += n;
+		return *this;
+	}
+
+	// Native byte order int32
+	BufferedWriter& putBinary(std::int32_t value)
+	{
+		return write(&value, sizeof(value));
+	}
+};
+
+// Write a graph of the given size; cost(i, j) returns the cost of the edge
+// i -> j in the caller's id space, zero if there is no edge.
+template <class CostFn>
+void writeGraph(std::ostream& out, int size, CostFn cost, OutputFormat format)
+{
+	if (format == OutputFormat::None)
+	{
+		return;
+	}
+
+	BufferedWriter w(out);
+	if (format == OutputFormat::Sparse)
+	{
+		w.put(static_cast<long long>(size)).put('\n');
+	}
+	else if (format == OutputFormat::Binary)
+	{
+		w.write("GRPH", 4).putBinary(size);
+	}
+
+	for (int i = 0; i < size; ++i)
+	{
+		for (int j = 0; j < size; ++j)
+		{
+			int c = cost(i, j);
+			switch (format)
+			{
+			case OutputFormat::Matrix:
+				w.put(static_cast<long long>(c)).put(' ');
+				break;
+			case OutputFormat::Sparse:
+				if (c)
+				{
+					w.put(static_cast<long long>(i)).put(' ');
+					w.put(static_cast<long long>(j)).put(' ');
+					w.put(static_cast<long long>(c)).put('\n');
+				}
+				break;
+			default:
+				if (c)
+				{
+					w.putBinary(i).putBinary(j).putBinary(c);
+				}
+				break;
+			}
+		}
+		if (format == OutputFormat::Matrix)
+		{
+			w.put('\n');
+		}
+	}
+}
+
+// EdgeWriter ADT
+// Writes edges as they are produced, in the Sparse or Binary format of
+// writeGraph, so a generated graph (generators.h) goes to disk without
+// ever being held in memory.  The vertex count goes first, so it must be
+// known up front.  Matrix is not supported: it needs every cell in order.
+class EdgeWriter
+{
+private:
+	BufferedWriter m_writer;
+	OutputFormat m_format;
+	long long m_edges;
+
+public:
+	EdgeWriter(std::ostream& out, long long size, OutputFormat format)
+		: m_writer(out), m_format(format), m_edges(0)
+	{
+		if (m_format == OutputFormat::Sparse)
+		{
+			m_writer.put(size).put('\n');
+		}
+		else if (m_format == OutputFormat::Binary)
+		{
+			m_writer.write("GRPH", 4).putBinary(static_cast<std::int32_t>(size));
+		}
+	};
+
+	void operator()(int i, int j, int c)
+	{
+		++m_edges;
+		if (m_format == OutputFormat::Sparse)
+		{
+			m_writer.put(static_cast<long long>(i)).put(' ');
+			m_writer.put(static_cast<long long>(j)).put(' ');
+			m_writer.put(static_cast<long long>(c)).put('\n');
+		}
+		else if (m_format == OutputFormat::Binary)
+		{
+			m_writer.putBinary(i).putBinary(j).putBinary(c);
+		}
+	}
+
+	long long edges() const { return m_edges; };
+	void flush() { m_writer.flush(); };
+};
@@ -0,0 +1,208 @@
+// Need the following as the first include for a Visual Studio environment
+#include "stdafx.h"
+
+/*
+Scalar kernels, CPU feature detection and dispatch.
+*/
+#include "kernels.h"
+#include "kernels_impl.h"
+
+#include <climits>
+
+#if defined(CORE_X86) && !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+namespace core
+{
+	namespace scalar
+	{
+		int minimumUnvisited(const int* values, const unsigned char* visited, int n)
+		{
+			int min_value = INT_MAX;
+			int min_index = -1;
+			for (int i = 0; i < n; ++i)
+			{
+				if (!visited[i] && values[i] < min_value)
+				{
+					min_value = values[i];
+					min_index = i;
+				}
+			}
+			return min_index;
+		}
+
+		int nonZeroIndices(const int* row, int n, int* out)
+		{
+			int count = 0;
+			for (int i = 0; i < n; ++i)
+			{
+				if (row[i])
+				{
+					out[count++] = i;
+				}
+			}
+			return count;
+		}
+
+		void randomBlocks(std::uint64_t* state, std::uint64_t* out, int blocks)
+		{
+			std::uint64_t* s0 = state;
+			std::uint64_t* s1 = state + 8;
+			std::uint64_t* s2 = state + 16;
+			std::uint64_t* s3 = state + 24;
+			for (int b = 0; b < blocks; ++b)
+			{
+				for (int l = 0; l < 8; ++l)
+				{
+					out[8 * b + l] = s0[l] + s3[l];
+					std::uint64_t t = s1[l] << 17;
+					s2[l] ^= s0[l];
+					s3[l] ^= s1[l];
+					s1[l] ^= s2[l];
+					s0[l] ^= s3[l];
+					s2[l] ^= t;
+					s3[l] = (s3[l] << 45) | (s3[l] >> 19);
+				}
+			}
+		}
+	}
+
+	namespace
+	{
+		struct Kernels
+		{
+			Isa isa;
+			int (*minimumUnvisited)(const int*, const unsigned char*, int);
+			int (*nonZeroIndices)(const int*, int, int*);
+			void (*randomBlocks)(std::uint64_t*, std::uint64_t*, int);
+		};
+
+		Kernels kernelsFor(Isa isa)
+		{
+			switch (isa)
+			{
+#ifdef CORE_X86
+			case Isa::Avx512:
+				return Kernels{ isa, avx512::minimumUnvisited, avx512::nonZeroIndices, avx512::randomBlocks };
+			case Isa::Avx2:
+				return Kernels{ isa, avx2::minimumUnvisited, avx2::nonZeroIndices, avx2::randomBlocks };
+			case Isa::Sse2:
+				return Kernels{ isa, sse2::minimumUnvisited, sse2::nonZeroIndices, sse2::randomBlocks };
+#endif
+			default:
+				return Kernels{ Isa::Scalar, scalar::minimumUnvisited, scalar::nonZeroIndices, scalar::randomBlocks };
+			}
+		}
+
+		Kernels& kernels()
+		{
+			static Kernels k = kernelsFor(detectIsa());
+			return k;
+		}
+
+#ifdef CORE_X86
+		void cpuid(int leaf, int sub, unsigned regs[4])
+		{
+#ifdef _MSC_VER
+			int r[4];
+			__cpuidex(r, leaf, sub);
+			for (int i = 0; i < 4; ++i)
+			{
+				regs[i] = static_cast<unsigned>(r[i]);
+			}
+#else
+			__cpuid_count(leaf, sub, regs[0], regs[1], regs[2], regs[3]);
+#endif
+		}
+
+		// Register state the OS saves on a context switch
+		unsigned long long xcr0()
+		{
+#ifdef _MSC_VER
+			return _xgetbv(0);
+#else
+			unsigned lo, hi;
+			__asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+			return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+		}
+#endif
+	}
+
+	Isa detectIsa()
+	{
+#ifdef CORE_X86
+		unsigned regs[4];
+		cpuid(0, 0, regs);
+		unsigned maxLeaf = regs[0];
+		cpuid(1, 0, regs);
+		bool sse2 = (regs[3] >> 26) & 1;
+		bool osxsave = (regs[2] >> 27) & 1;
+		bool avx = (regs[2] >> 28) & 1;
+		if (!sse2)
+		{
+			return Isa::Scalar;
+		}
+		// AVX needs the OS to save the YMM registers, AVX-512 also the
+		// opmask and ZMM registers.
+		unsigned long long xcr = (osxsave && avx) ? xcr0() : 0;
+		if (maxLeaf < 7 || (xcr & 0x6) != 0x6)
+		{
+			return Isa::Sse2;
+		}
+		cpuid(7, 0, regs);
+		bool avx2 = (regs[1] >> 5) & 1;
+		bool avx512f = (regs[1] >> 16) & 1;
+		if (avx512f && (xcr & 0xE6) == 0xE6)
+		{
+			return Isa::Avx512;
+		}
+		return avx2 ? Isa::Avx2 : Isa::Sse2;
+#else
+		return Isa::Scalar;
+#endif
+	}
+
+	Isa activeIsa()
+	{
+		return kernels().isa;
+	}
+
+	Isa selectIsa(Isa isa)
+	{
+		Isa best = detectIsa();
+		kernels() = kernelsFor(static_cast<int>(isa) < static_cast<int>(best) ? isa : best);
+		return kernels().isa;
+	}
+
+	const char* isaName(Isa isa)
+	{
+		switch (isa)
+		{
+		case Isa::Sse2:
+			return "sse2";
+		case Isa::Avx2:
+			return "avx2";
+		case Isa::Avx512:
+			return "avx512";
+		default:
+			return "scalar";
+		}
+	}
+
+	int minimumUnvisited(const int* values, const unsigned char* visited, int n)
+	{
+		return kernels().minimumUnvisited(values, visited, n);
+	}
+
+	int nonZeroIndices(const int* row, int n, int* out)
+	{
+		return kernels().nonZeroIndices(row, n, out);
+	}
+
+	void randomBlocks(std::uint64_t* state, std::uint64_t* out, int blocks)
+	{
+		kernels().randomBlocks(state, out, blocks);
+	}
+}
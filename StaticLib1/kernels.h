@@ -0,0 +1,46 @@
+/*
+Hot loops of the matrix graph solvers, compiled for several instruction
+set levels.
+
+Every kernel has a scalar version and SSE2, AVX2 and AVX-512 versions
+(kernels_sse2.cpp, kernels_avx2.cpp, kernels_avx512.cpp, each built for
+its own ISA).  The first call picks the best version the CPU and the OS
+support, so one binary runs everywhere and uses the widest vectors
+available.
+*/
+#pragma once
+#include <cstdint>
+
+namespace core
+{
+	enum class Isa
+	{
+		Scalar,
+		Sse2,
+		Avx2,
+		Avx512
+	};
+
+	// Best level supported by this CPU and OS
+	Isa detectIsa();
+	// Level of the kernels in use
+	Isa activeIsa();
+	// Use the kernels of the given level, or of the best supported level
+	// below it.  For tests and benchmarks; call before any other thread
+	// uses the kernels.  Returns the level actually selected.
+	Isa selectIsa(Isa isa);
+	const char* isaName(Isa isa);
+
+	// Index of the smallest values[i] with visited[i] == 0, the first one
+	// if there are several; -1 if every such value is INT_MAX.
+	int minimumUnvisited(const int* values, const unsigned char* visited, int n);
+
+	// Store the indices of the non zero row entries in out (room for n)
+	// in increasing order and return how many there are.
+	int nonZeroIndices(const int* row, int n, int* out);
+
+	// Step 8 interleaved xoshiro256+ generators blocks times and store
+	// out[8 * b + l] = output l of step b.  state[8 * k + l] is word k of
+	// generator l.
+	void randomBlocks(std::uint64_t* state, std::uint64_t* out, int blocks);
+}
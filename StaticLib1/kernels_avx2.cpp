@@ -0,0 +1,102 @@
+// Need the following as the first include for a Visual Studio environment
+#include "stdafx.h"
+
+/*
+AVX2 kernels, 8 ints per step.  Built with /arch:AVX2 (-mavx2); only
+called when detectIsa() reports AVX2.
+*/
+#include "kernels_impl.h"
+
+#ifdef CORE_X86
+#include <immintrin.h>
+
+namespace core
+{
+	namespace avx2
+	{
+		int minimumUnvisited(const int* values, const unsigned char* visited, int n)
+		{
+			const __m256i zero = _mm256_setzero_si256();
+			const __m256i step = _mm256_set1_epi32(8);
+			__m256i best = _mm256_set1_epi32(INT_MAX);
+			__m256i bestIndex = _mm256_set1_epi32(-1);
+			__m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+			int i = 0;
+			for (; i + 8 <= n; i += 8)
+			{
+				__m256i seen = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(visited + i)));
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+				__m256i less = _mm256_andnot_si256(_mm256_cmpgt_epi32(seen, zero), _mm256_cmpgt_epi32(best, v));
+				best = _mm256_blendv_epi8(best, v, less);
+				bestIndex = _mm256_blendv_epi8(bestIndex, index, less);
+				index = _mm256_add_epi32(index, step);
+			}
+			alignas(32) int laneValue[8];
+			alignas(32) int laneIndex[8];
+			_mm256_store_si256(reinterpret_cast<__m256i*>(laneValue), best);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(laneIndex), bestIndex);
+			return finishMinimum(laneValue, laneIndex, 8, values, visited, i, n);
+		}
+
+		int nonZeroIndices(const int* row, int n, int* out)
+		{
+			const __m256i zero = _mm256_setzero_si256();
+			int count = 0;
+			int i = 0;
+			for (; i + 8 <= n; i += 8)
+			{
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+				unsigned mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, zero))) & 0xFF;
+				while (mask)
+				{
+					out[count++] = i + lowestBit(mask);
+					mask &= mask - 1;
+				}
+			}
+			for (; i < n; ++i)
+			{
+				if (row[i])
+				{
+					out[count++] = i;
+				}
+			}
+			return count;
+		}
+
+		// 4 generators per register
+		void randomBlocks(std::uint64_t* state, std::uint64_t* out, int blocks)
+		{
+			__m256i* s = reinterpret_cast<__m256i*>(state);
+			__m256i s0[2], s1[2], s2[2], s3[2];
+			for (int h = 0; h < 2; ++h)
+			{
+				s0[h] = _mm256_loadu_si256(s + h);
+				s1[h] = _mm256_loadu_si256(s + 2 + h);
+				s2[h] = _mm256_loadu_si256(s + 4 + h);
+				s3[h] = _mm256_loadu_si256(s + 6 + h);
+			}
+			for (int b = 0; b < blocks; ++b)
+			{
+				for (int h = 0; h < 2; ++h)
+				{
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 8 * b) + h, _mm256_add_epi64(s0[h], s3[h]));
+					__m256i t = _mm256_slli_epi64(s1[h], 17);
+					s2[h] = _mm256_xor_si256(s2[h], s0[h]);
+					s3[h] = _mm256_xor_si256(s3[h], s1[h]);
+					s1[h] = _mm256_xor_si256(s1[h], s2[h]);
+					s0[h] = _mm256_xor_si256(s0[h], s3[h]);
+					s2[h] = _mm256_xor_si256(s2[h], t);
+					s3[h] = _mm256_or_si256(_mm256_slli_epi64(s3[h], 45), _mm256_srli_epi64(s3[h], 19));
+				}
+			}
+			for (int h = 0; h < 2; ++h)
+			{
+				_mm256_storeu_si256(s + h, s0[h]);
+				_mm256_storeu_si256(s + 2 + h, s1[h]);
+				_mm256_storeu_si256(s + 4 + h, s2[h]);
+				_mm256_storeu_si256(s + 6 + h, s3[h]);
+			}
+		}
+	}
+}
+#endif
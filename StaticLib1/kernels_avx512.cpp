@@ -0,0 +1,91 @@
+// Need the following as the first include for a Visual Studio environment
+#include "stdafx.h"
+
+/*
+AVX-512F kernels, 16 ints per step.  Only called when detectIsa() reports
+AVX-512.
+*/
+#include "kernels_impl.h"
+
+#ifdef CORE_X86
+#include <immintrin.h>
+
+namespace core
+{
+	namespace avx512
+	{
+		int minimumUnvisited(const int* values, const unsigned char* visited, int n)
+		{
+			const __m512i zero = _mm512_setzero_si512();
+			const __m512i step = _mm512_set1_epi32(16);
+			__m512i best = _mm512_set1_epi32(INT_MAX);
+			__m512i bestIndex = _mm512_set1_epi32(-1);
+			__m512i index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+			int i = 0;
+			for (; i + 16 <= n; i += 16)
+			{
+				__m512i seen = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(visited + i)));
+				__m512i v = _mm512_loadu_si512(values + i);
+				__mmask16 open = _mm512_cmpeq_epi32_mask(seen, zero);
+				__mmask16 less = _mm512_mask_cmplt_epi32_mask(open, v, best);
+				best = _mm512_mask_mov_epi32(best, less, v);
+				bestIndex = _mm512_mask_mov_epi32(bestIndex, less, index);
+				index = _mm512_add_epi32(index, step);
+			}
+			alignas(64) int laneValue[16];
+			alignas(64) int laneIndex[16];
+			_mm512_store_si512(laneValue, best);
+			_mm512_store_si512(laneIndex, bestIndex);
+			return finishMinimum(laneValue, laneIndex, 16, values, visited, i, n);
+		}
+
+		int nonZeroIndices(const int* row, int n, int* out)
+		{
+			int count = 0;
+			int i = 0;
+			for (; i + 16 <= n; i += 16)
+			{
+				__m512i v = _mm512_loadu_si512(row + i);
+				unsigned mask = _mm512_test_epi32_mask(v, v);
+				while (mask)
+				{
+					out[count++] = i + lowestBit(mask);
+					mask &= mask - 1;
+				}
+			}
+			for (; i < n; ++i)
+			{
+				if (row[i])
+				{
+					out[count++] = i;
+				}
+			}
+			return count;
+		}
+
+		// All 8 generators in one register
+		void randomBlocks(std::uint64_t* state, std::uint64_t* out, int blocks)
+		{
+			__m512i s0 = _mm512_loadu_si512(state);
+			__m512i s1 = _mm512_loadu_si512(state + 8);
+			__m512i s2 = _mm512_loadu_si512(state + 16);
+			__m512i s3 = _mm512_loadu_si512(state + 24);
+			for (int b = 0; b < blocks; ++b)
+			{
+				_mm512_storeu_si512(out + 8 * b, _mm512_add_epi64(s0, s3));
+				__m512i t = _mm512_slli_epi64(s1, 17);
+				s2 = _mm512_xor_si512(s2, s0);
+				s3 = _mm512_xor_si512(s3, s1);
+				s1 = _mm512_xor_si512(s1, s2);
+				s0 = _mm512_xor_si512(s0, s3);
+				s2 = _mm512_xor_si512(s2, t);
+				s3 = _mm512_rol_epi64(s3, 45);
+			}
+			_mm512_storeu_si512(state, s0);
+			_mm512_storeu_si512(state + 8, s1);
+			_mm512_storeu_si512(state + 16, s2);
+			_mm512_storeu_si512(state + 24, s3);
+		}
+	}
+}
+#endif
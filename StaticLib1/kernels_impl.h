@@ -0,0 +1,88 @@
+/*
+Per-ISA kernel entry points, only for the kernels_*.cpp files.
+*/
+#pragma once
+#include <climits>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CORE_X86 1
+#endif
+
+namespace core
+{
+	// The helpers are compiled into every kernels_*.cpp, each with its own
+	// /arch.  Internal linkage keeps one copy per file: as plain inline
+	// functions the linker would keep any one of them, and the scalar path
+	// could end up calling an AVX encoded body.
+	namespace
+	{
+	// Position of the lowest set bit of a non zero mask
+	inline int lowestBit(unsigned mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return static_cast<int>(index);
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	// Combine the per lane minima of a vector loop (first index among equal
+	// values) and finish the elements [from, n) the loop did not cover.
+	inline int finishMinimum(const int* laneValue, const int* laneIndex, int lanes,
+		const int* values, const unsigned char* visited, int from, int n)
+	{
+		int min_value = INT_MAX;
+		int min_index = -1;
+		for (int l = 0; l < lanes; ++l)
+		{
+			if (laneValue[l] < min_value || (laneValue[l] == min_value && laneValue[l] != INT_MAX && laneIndex[l] < min_index))
+			{
+				min_value = laneValue[l];
+				min_index = laneIndex[l];
+			}
+		}
+		for (int i = from; i < n; ++i)
+		{
+			if (!visited[i] && values[i] < min_value)
+			{
+				min_value = values[i];
+				min_index = i;
+			}
+		}
+		return min_index;
+	}
+	}
+
+	namespace scalar
+	{
+		int minimumUnvisited(const int* values, const unsigned char* visited, int n);
+		int nonZeroIndices(const int* row, int n, int* out);
+		void randomBlocks(std::uint64_t* state, std::uint64_t* out, int blocks);
+	}
+#ifdef CORE_X86
+	namespace sse2
+	{
+		int minimumUnvisited(const int* values, const unsigned char* visited, int n);
+		int nonZeroIndices(const int* row, int n, int* out);
+		void randomBlocks(std::uint64_t* state, std::uint64_t* out, int blocks);
+	}
+	namespace avx2
+	{
+		int minimumUnvisited(const int* values, const unsigned char* visited, int n);
+		int nonZeroIndices(const int* row, int n, int* out);
+		void randomBlocks(std::uint64_t* state, std::uint64_t* out, int blocks);
+	}
+	namespace avx512
+	{
+		int minimumUnvisited(const int* values, const unsigned char* visited, int n);
+		int nonZeroIndices(const int* row, int n, int* out);
+		void randomBlocks(std::uint64_t* state, std::uint64_t* out, int blocks);
+	}
+#endif
+}
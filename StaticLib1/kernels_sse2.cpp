@@ -0,0 +1,103 @@
+// Need the following as the first include for a Visual Studio environment
+#include "stdafx.h"
+
+/*
+SSE2 kernels, 4 ints per step.
+*/
+#include "kernels_impl.h"
+
+#ifdef CORE_X86
+#include <emmintrin.h>
+#include <cstring>
+
+namespace core
+{
+	namespace sse2
+	{
+		// a where mask is set, b elsewhere (SSE2 has no blend)
+		static inline __m128i select(__m128i mask, __m128i a, __m128i b)
+		{
+			return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+		}
+
+		int minimumUnvisited(const int* values, const unsigned char* visited, int n)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i step = _mm_set1_epi32(4);
+			__m128i best = _mm_set1_epi32(INT_MAX);
+			__m128i bestIndex = _mm_set1_epi32(-1);
+			__m128i index = _mm_set_epi32(3, 2, 1, 0);
+			int i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				int flags;
+				std::memcpy(&flags, visited + i, sizeof(flags));
+				__m128i seen = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(flags), zero), zero);
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+				__m128i less = _mm_andnot_si128(_mm_cmpgt_epi32(seen, zero), _mm_cmplt_epi32(v, best));
+				best = select(less, v, best);
+				bestIndex = select(less, index, bestIndex);
+				index = _mm_add_epi32(index, step);
+			}
+			alignas(16) int laneValue[4];
+			alignas(16) int laneIndex[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(laneValue), best);
+			_mm_store_si128(reinterpret_cast<__m128i*>(laneIndex), bestIndex);
+			return finishMinimum(laneValue, laneIndex, 4, values, visited, i, n);
+		}
+
+		int nonZeroIndices(const int* row, int n, int* out)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			int count = 0;
+			int i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+				unsigned mask = ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, zero))) & 0xF;
+				while (mask)
+				{
+					out[count++] = i + lowestBit(mask);
+					mask &= mask - 1;
+				}
+			}
+			for (; i < n; ++i)
+			{
+				if (row[i])
+				{
+					out[count++] = i;
+				}
+			}
+			return count;
+		}
+
+		// 2 generators per register; SSE2 has no 64 bit rotate
+		void randomBlocks(std::uint64_t* state, std::uint64_t* out, int blocks)
+		{
+			__m128i* s = reinterpret_cast<__m128i*>(state);
+			for (int h = 0; h < 4; ++h)
+			{
+				__m128i s0 = _mm_loadu_si128(s + h);
+				__m128i s1 = _mm_loadu_si128(s + 4 + h);
+				__m128i s2 = _mm_loadu_si128(s + 8 + h);
+				__m128i s3 = _mm_loadu_si128(s + 12 + h);
+				for (int b = 0; b < blocks; ++b)
+				{
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8 * b) + h, _mm_add_epi64(s0, s3));
+					__m128i t = _mm_slli_epi64(s1, 17);
+					s2 = _mm_xor_si128(s2, s0);
+					s3 = _mm_xor_si128(s3, s1);
+					s1 = _mm_xor_si128(s1, s2);
+					s0 = _mm_xor_si128(s0, s3);
+					s2 = _mm_xor_si128(s2, t);
+					s3 = _mm_or_si128(_mm_slli_epi64(s3, 45), _mm_srli_epi64(s3, 19));
+				}
+				_mm_storeu_si128(s + h, s0);
+				_mm_storeu_si128(s + 4 + h, s1);
+				_mm_storeu_si128(s + 8 + h, s2);
+				_mm_storeu_si128(s + 12 + h, s3);
+			}
+		}
+	}
+}
+#endif
@@ -0,0 +1,151 @@
+// Need the following as the first include for a Visual Studio environment
+#include "stdafx.h"
+
+/*
+MappedFile over the Win32 file mapping calls on Windows and mmap on POSIX.
+*/
+#include "mapped_file.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_file(nullptr), m_mapping(nullptr)
+{
+}
+
+MappedFile::MappedFile(const std::string& path) : MappedFile()
+{
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+	m_file = file;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		close();
+		return;
+	}
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_mapping)
+	{
+		close();
+		return;
+	}
+	m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_data)
+	{
+		close();
+		return;
+	}
+	m_size = static_cast<std::size_t>(size.QuadPart);
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping)
+	{
+		CloseHandle(m_mapping);
+	}
+	if (m_file)
+	{
+		CloseHandle(m_file);
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_file = nullptr;
+	m_mapping = nullptr;
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+	: m_data(other.m_data), m_size(other.m_size), m_file(other.m_file), m_mapping(other.m_mapping)
+{
+	other.m_data = nullptr;
+	other.m_size = 0;
+	other.m_file = nullptr;
+	other.m_mapping = nullptr;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+	if (this != &other)
+	{
+		close();
+		std::swap(m_data, other.m_data);
+		std::swap(m_size, other.m_size);
+		std::swap(m_file, other.m_file);
+		std::swap(m_mapping, other.m_mapping);
+	}
+	return *this;
+}
+#else
+MappedFile::MappedFile() : m_data(nullptr), m_size(0)
+{
+}
+
+MappedFile::MappedFile(const std::string& path) : MappedFile()
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return;
+	}
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		void* p = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+		if (p != MAP_FAILED)
+		{
+			m_data = p;
+			m_size = static_cast<std::size_t>(st.st_size);
+		}
+	}
+	// The mapping keeps the file alive
+	::close(fd);
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+	{
+		munmap(const_cast<void*>(m_data), m_size);
+	}
+	m_data = nullptr;
+	m_size = 0;
+}
+
+MappedFile::MappedFile(MappedFile&& other) : m_data(other.m_data), m_size(other.m_size)
+{
+	other.m_data = nullptr;
+	other.m_size = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+	if (this != &other)
+	{
+		close();
+		std::swap(m_data, other.m_data);
+		std::swap(m_size, other.m_size);
+	}
+	return *this;
+}
+#endif
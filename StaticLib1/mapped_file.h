@@ -0,0 +1,41 @@
+/*
+Read-only memory mapped file.
+
+The pages of the file are only read from disk when they are first
+touched, and they live in the OS page cache rather than the process heap:
+opening a large file costs nothing up front, several processes mapping
+the same file share one copy, and a restarted process finds the pages
+still cached.  mmap on POSIX, MapViewOfFile on Windows.
+*/
+#pragma once
+#include <cstddef>
+#include <string>
+
+// MappedFile ADT
+// Move only; the mapping is released with the object.
+class MappedFile
+{
+private:
+	const void* m_data;
+	std::size_t m_size;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#endif
+
+	void close();
+
+public:
+	MappedFile();
+	// Not open if the file cannot be opened or is empty
+	explicit MappedFile(const std::string& path);
+	~MappedFile() { close(); };
+	MappedFile(MappedFile&& other);
+	MappedFile& operator=(MappedFile&& other);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool isOpen() const { return m_data != nullptr; };
+	const void* data() const { return m_data; };
+	std::size_t size() const { return m_size; };
+};
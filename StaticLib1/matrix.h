@@ -0,0 +1,299 @@
+/*
+Dense row major matrix in a single aligned allocation.
+
+A std::vector<std::vector<T>> costs one allocation per row, a pointer
+chase per access and gives no alignment.  Matrix<T> keeps all the rows in
+one block:
+
+	- the block starts on a 64 byte (cache line) boundary
+	- every row is padded to a multiple of 64 bytes (stride() elements),
+	  so each row starts aligned as well and SIMD loops over a row never
+	  straddle into the next one; padding is always zero
+	- m[i] is a pointer to row i, so m[i][j] works as with nested vectors,
+	  and row(i) is a reduce::Span over the cols() real elements
+	- transpose() works in cache sized tiles
+	- MatrixMemory::HugePages backs large matrices with 2 MB pages where
+	  the OS allows it (on Linux the reserved hugetlbfs pool if there is
+	  one, else transparent huge pages by madvise; MEM_LARGE_PAGES on
+	  Windows, which needs the "Lock pages in memory" privilege) and
+	  silently falls back to normal pages otherwise
+	- MatrixMemory::Interleaved spreads the pages round robin over the
+	  NUMA nodes (numa.h) instead of leaving them all on the node of the
+	  allocating thread; it combines with HugePages, except on Windows
+	  where large pages are placed when they are allocated
+	- the block is charged to a footprint.h component (Graph by default),
+	  the row padding as overhead
+
+T must be trivially copyable; the graphs use int.
+*/
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <malloc.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "reduce.h"
+#include "footprint.h"
+#include "numa.h"
+
+// Flags, e.g. MatrixMemory::HugePages | MatrixMemory::Interleaved
+enum class MatrixMemory
+{
+	// Normal pages, placed on the node of the thread allocating the matrix
+	Default = 0,
+	HugePages = 1,
+	Interleaved = 2
+};
+
+inline MatrixMemory operator|(MatrixMemory a, MatrixMemory b)
+{
+	return static_cast<MatrixMemory>(static_cast<int>(a) | static_cast<int>(b));
+}
+
+inline bool hasFlag(MatrixMemory memory, MatrixMemory flag)
+{
+	return (static_cast<int>(memory) & static_cast<int>(flag)) != 0;
+}
+
+template <class T>
+class Matrix
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Matrix<T> needs a trivially copyable T");
+
+public:
+	static const std::size_t alignment = 64;
+	// Huge page size assumed for the placement and rounding of mapped blocks
+	static const std::size_t hugePage = 2 << 20;
+
+private:
+	T* m_data;
+	std::size_t m_rows;
+	std::size_t m_cols;
+	std::size_t m_stride;
+	MatrixMemory m_memory;
+	footprint::Component m_component;
+	// Set when the block came from the huge page allocator
+	bool m_mapped;
+
+	static std::size_t padded(std::size_t cols)
+	{
+		std::size_t perLine = alignment / sizeof(T) ? alignment / sizeof(T) : 1;
+		return (cols + perLine - 1) / perLine * perLine;
+	}
+
+	std::size_t bytes() const { return m_rows * m_stride * sizeof(T); };
+	std::size_t paddingBytes() const { return m_rows * (m_stride - m_cols) * sizeof(T); };
+
+	void allocate()
+	{
+		m_data = nullptr;
+		m_mapped = false;
+		std::size_t n = bytes();
+		if (n == 0)
+		{
+			return;
+		}
+		if (hasFlag(m_memory, MatrixMemory::HugePages))
+		{
+#ifdef _WIN32
+			SIZE_T large = GetLargePageMinimum();
+			if (large)
+			{
+				SIZE_T size = (n + large - 1) / large * large;
+				m_data = static_cast<T*>(VirtualAlloc(nullptr, size,
+					MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE));
+			}
+#else
+			std::size_t size = (n + hugePage - 1) / hugePage * hugePage;
+			void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+			// Explicit huge pages, if the administrator reserved a pool
+			p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+			if (p == MAP_FAILED)
+			{
+				// Transparent huge pages
+				p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			}
+			if (p != MAP_FAILED)
+			{
+#ifdef MADV_HUGEPAGE
+				madvise(p, size, MADV_HUGEPAGE);
+#endif
+				m_data = static_cast<T*>(p);
+			}
+#endif
+			m_mapped = m_data != nullptr;
+		}
+		if (!m_data)
+		{
+			// Round up to a multiple of the alignment for aligned_alloc
+			std::size_t size = (n + alignment - 1) / alignment * alignment;
+#ifdef _WIN32
+			m_data = static_cast<T*>(_aligned_malloc(size, alignment));
+#else
+			m_data = static_cast<T*>(std::aligned_alloc(alignment, size));
+#endif
+			if (!m_data)
+			{
+				throw std::bad_alloc();
+			}
+		}
+		if (hasFlag(m_memory, MatrixMemory::Interleaved))
+		{
+			numa::interleave(m_data, n, m_mapped ? hugePage : 4096);
+		}
+		else
+		{
+			std::memset(m_data, 0, n);
+		}
+		footprint::allocated(m_component, n, paddingBytes());
+	}
+
+	void release()
+	{
+		if (!m_data)
+		{
+			return;
+		}
+		footprint::released(m_component, bytes(), paddingBytes());
+		if (m_mapped)
+		{
+#ifdef _WIN32
+			VirtualFree(m_data, 0, MEM_RELEASE);
+#else
+			munmap(m_data, (bytes() + hugePage - 1) / hugePage * hugePage);
+#endif
+		}
+		else
+		{
+#ifdef _WIN32
+			_aligned_free(m_data);
+#else
+			std::free(m_data);
+#endif
+		}
+		m_data = nullptr;
+	}
+
+public:
+	Matrix() : m_data(nullptr), m_rows(0), m_cols(0), m_stride(0), m_memory(MatrixMemory::Default),
+		m_component(footprint::Component::Graph), m_mapped(false) {};
+	Matrix(std::size_t rows, std::size_t cols, MatrixMemory memory = MatrixMemory::Default,
+		footprint::Component component = footprint::Component::Graph)
+		: m_rows(rows), m_cols(cols), m_stride(padded(cols)), m_memory(memory), m_component(component)
+	{
+		allocate();
+	}
+	Matrix(const Matrix& m)
+		: m_rows(m.m_rows), m_cols(m.m_cols), m_stride(m.m_stride), m_memory(m.m_memory),
+		m_component(m.m_component)
+	{
+		allocate();
+		if (m_data)
+		{
+			std::memcpy(m_data, m.m_data, bytes());
+		}
+	}
+	Matrix(Matrix&& m) noexcept
+		: m_data(m.m_data), m_rows(m.m_rows), m_cols(m.m_cols), m_stride(m.m_stride),
+		m_memory(m.m_memory), m_component(m.m_component), m_mapped(m.m_mapped)
+	{
+		m.m_data = nullptr;
+		m.m_rows = m.m_cols = m.m_stride = 0;
+	}
+	Matrix& operator=(Matrix m) noexcept
+	{
+		swap(m);
+		return *this;
+	}
+	~Matrix() { release(); };
+
+	void swap(Matrix& m) noexcept
+	{
+		std::swap(m_data, m.m_data);
+		std::swap(m_rows, m.m_rows);
+		std::swap(m_cols, m.m_cols);
+		std::swap(m_stride, m.m_stride);
+		std::swap(m_memory, m.m_memory);
+		std::swap(m_component, m.m_component);
+		std::swap(m_mapped, m.m_mapped);
+	}
+
+	std::size_t rows() const { return m_rows; };
+	std::size_t cols() const { return m_cols; };
+	// Elements from the start of one row to the start of the next
+	std::size_t stride() const { return m_stride; };
+	// Number of rows, as with the nested vectors
+	std::size_t size() const { return m_rows; };
+	bool hugePages() const { return m_mapped; };
+	T* data() { return m_data; };
+	const T* data() const { return m_data; };
+
+	T* operator[](std::size_t i) { return m_data + i * m_stride; };
+	const T* operator[](std::size_t i) const { return m_data + i * m_stride; };
+	reduce::Span<T> row(std::size_t i) const { return reduce::Span<T>((*this)[i], m_cols); };
+
+	// Resize keeping the overlapping elements; new elements are zero
+	void resize(std::size_t rows, std::size_t cols)
+	{
+		if (rows == m_rows && cols == m_cols)
+		{
+			return;
+		}
+		Matrix m(rows, cols, m_memory, m_component);
+		std::size_t r = std::min(rows, m_rows);
+		std::size_t c = std::min(cols, m_cols);
+		for (std::size_t i = 0; i < r; ++i)
+		{
+			std::memcpy(m[i], (*this)[i], c * sizeof(T));
+		}
+		swap(m);
+	}
+
+	// Set every element, leaving the padding zero
+	void fill(const T& value)
+	{
+		for (std::size_t i = 0; i < m_rows; ++i)
+		{
+			std::fill((*this)[i], (*this)[i] + m_cols, value);
+		}
+	}
+
+	// Tiled so that both the rows read and the rows written stay in cache
+	Matrix transpose() const
+	{
+		const std::size_t tile = 64 / sizeof(T) ? 64 / sizeof(T) : 1;
+		Matrix t(m_cols, m_rows, m_memory, m_component);
+		for (std::size_t ii = 0; ii < m_rows; ii += tile)
+		{
+			std::size_t iend = std::min(ii + tile, m_rows);
+			for (std::size_t jj = 0; jj < m_cols; jj += tile)
+			{
+				std::size_t jend = std::min(jj + tile, m_cols);
+				for (std::size_t i = ii; i < iend; ++i)
+				{
+					const T* src = (*this)[i];
+					for (std::size_t j = jj; j < jend; ++j)
+					{
+						t[j][i] = src[j];
+					}
+				}
+			}
+		}
+		return t;
+	}
+};
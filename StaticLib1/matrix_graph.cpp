@@ -0,0 +1,46 @@
+// Need the following as the first include for a Visual Studio environment
+#include "stdafx.h"
+
+#include "matrix_graph.h"
+#include "kernels.h"
+#include "trace.h"
+
+std::size_t MatrixGraph::memoryBytes() const
+{
+	// The permutation holds both directions once the graph is reordered
+	std::size_t ids = m_ids.empty() ? 0 : 2 * static_cast<std::size_t>(m_size) * sizeof(int);
+	return m_matrix.rows() * m_matrix.stride() * sizeof(int) + ids;
+}
+
+// Return a container of vertex Ids.
+std::vector<int> MatrixGraph::neighbors(int v) const
+{
+	std::vector<int> neighbor(m_matrix.cols());
+	neighbor.resize(core::nonZeroIndices(m_matrix[v], static_cast<int>(m_matrix.cols()), neighbor.data()));
+	return neighbor;
+}
+
+void MatrixGraph::reorder(Ordering o)
+{
+	TRACE_SCOPE("reorder");
+	Permutation p = ordering(m_matrix, m_size, o);
+	permute(m_matrix, m_size, p);
+	m_ids = m_ids.then(p);
+}
+
+// Write a Graph
+void MatrixGraph::write(std::ostream& out, OutputFormat format) const
+{
+	TRACE_SCOPE("write");
+	// Always write in the external id order
+	writeGraph(out, m_size,
+		[this](int i, int j) { return m_matrix[internalId(i)][internalId(j)]; },
+		format);
+}
+
+// Print a Graph
+std::ostream& operator<<(std::ostream& out, const MatrixGraph& g)
+{
+	g.write(out, OutputFormat::Matrix);
+	return out;
+}
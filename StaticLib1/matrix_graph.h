@@ -0,0 +1,68 @@
+/*
+Dense matrix graph shared by the dijkstra and mst programs.
+
+The cost matrix is v x v; m_matrix[i][j] is either a non-zero cost or
+zero, meaning there is no edge between i and j.  The matrix is a single
+aligned block (matrix.h).  After reorder() the matrix ids differ from the
+ids the graph was built with (external ids); internalId()/externalId()
+map between the two.
+
+The programs derive their Graph from MatrixGraph and add the way they
+build it (random generation, data file).
+*/
+#pragma once
+#include <iostream>
+#include <vector>
+
+#include "matrix.h"
+#include "reduce.h"
+#include "reorder.h"
+#include "graph_io.h"
+#include "footprint.h"
+
+// MatrixGraph ADT
+class MatrixGraph
+{
+protected:
+	Matrix<int> m_matrix;
+	int m_size;
+	// Maps the external ids to the matrix ids after reorder()
+	Permutation m_ids;
+	footprint::GraphCopies m_copies;
+
+public:
+	explicit MatrixGraph(int size = 0) : m_size(size) {};
+
+	int vertices() const { return m_size; };
+	// Heap bytes held by the graph
+	std::size_t memoryBytes() const;
+	// Neighbors of matrix vertex v, in matrix ids
+	std::vector<int> neighbors(int v) const;
+	int cost(int s, int d) const { return m_matrix[s][d]; };
+	bool adjacent(int s, int d) const { return m_matrix[s][d] > 0; };
+	// Costs of the edges leaving matrix vertex v
+	reduce::Span<int> row(int v) const { return m_matrix.row(v); };
+	// f(neighbor, cost) for every edge leaving matrix vertex v, as for the
+	// graph::Graph storages
+	template <class F>
+	void forEachNeighbor(int v, F&& f) const
+	{
+		const int* costs = m_matrix[v];
+		for (int j = 0; j < m_size; ++j)
+		{
+			if (costs[j])
+			{
+				f(j, costs[j]);
+			}
+		}
+	}
+	// Renumber the vertices so that neighbors end up close together in the
+	// matrix and in the solver arrays.
+	void reorder(Ordering o);
+	int internalId(int v) const { return m_ids.toNew(v); };
+	int externalId(int v) const { return m_ids.toOld(v); };
+	// Write the graph in external id order, see graph_io.h
+	void write(std::ostream& out, OutputFormat format) const;
+
+	friend std::ostream& operator<<(std::ostream& out, const MatrixGraph& g);
+};
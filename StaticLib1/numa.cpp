@@ -0,0 +1,238 @@
+// Need the following as the first include for a Visual Studio environment
+#include "stdafx.h"
+
+/*
+Topology discovery and thread affinity for numa.h: the Win32 NUMA calls
+on Windows, sysfs and sched affinity on Linux, a single node elsewhere.
+*/
+#include "numa.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace numa
+{
+	namespace
+	{
+#ifdef _WIN32
+		struct Topology
+		{
+			int nodes;
+			DWORD_PTR process;
+
+			Topology() : nodes(1), process(0)
+			{
+				ULONG highest = 0;
+				if (GetNumaHighestNodeNumber(&highest))
+				{
+					nodes = static_cast<int>(highest) + 1;
+				}
+				DWORD_PTR system = 0;
+				GetProcessAffinityMask(GetCurrentProcess(), &process, &system);
+			}
+		};
+#elif defined(__linux__)
+		// "0-3,8-11" style lists of /sys/devices/system/node/node<n>/cpulist
+		std::vector<int> parseCpuList(const std::string& list)
+		{
+			std::vector<int> cpus;
+			std::stringstream in(list);
+			std::string range;
+			while (std::getline(in, range, ','))
+			{
+				int first = 0;
+				int last = 0;
+				std::size_t dash = range.find('-');
+				try
+				{
+					first = std::stoi(range.substr(0, dash));
+					last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+				}
+				catch (...)
+				{
+					continue;
+				}
+				for (int c = first; c <= last; ++c)
+				{
+					cpus.push_back(c);
+				}
+			}
+			return cpus;
+		}
+
+		struct Topology
+		{
+			// CPUs of each node the process may run on; nodes without any
+			// are left out.
+			std::vector<std::vector<int>> cpus;
+			std::vector<int> nodeOfCpu;
+			cpu_set_t process;
+
+			Topology()
+			{
+				CPU_ZERO(&process);
+				sched_getaffinity(0, sizeof(process), &process);
+				for (int n = 0; n < 1024; ++n)
+				{
+					std::ifstream in("/sys/devices/system/node/node" + std::to_string(n) + "/cpulist");
+					std::string list;
+					if (!in || !std::getline(in, list))
+					{
+						continue;
+					}
+					std::vector<int> allowed;
+					for (int c : parseCpuList(list))
+					{
+						if (c < CPU_SETSIZE && CPU_ISSET(c, &process))
+						{
+							allowed.push_back(c);
+						}
+					}
+					if (allowed.empty())
+					{
+						continue;
+					}
+					for (int c : allowed)
+					{
+						if (c >= static_cast<int>(nodeOfCpu.size()))
+						{
+							nodeOfCpu.resize(c + 1, 0);
+						}
+						nodeOfCpu[c] = static_cast<int>(cpus.size());
+					}
+					cpus.push_back(allowed);
+				}
+			}
+		};
+#endif
+
+#if defined(_WIN32) || defined(__linux__)
+		const Topology& topology()
+		{
+			static Topology t;
+			return t;
+		}
+#endif
+	}
+
+	int nodes()
+	{
+#ifdef _WIN32
+		return topology().nodes;
+#elif defined(__linux__)
+		return std::max<int>(1, static_cast<int>(topology().cpus.size()));
+#else
+		return 1;
+#endif
+	}
+
+	int currentNode()
+	{
+#ifdef _WIN32
+		PROCESSOR_NUMBER processor;
+		GetCurrentProcessorNumberEx(&processor);
+		USHORT node = 0;
+		if (!GetNumaProcessorNodeEx(&processor, &node))
+		{
+			return 0;
+		}
+		return std::min<int>(node, nodes() - 1);
+#elif defined(__linux__)
+		int cpu = sched_getcpu();
+		const Topology& t = topology();
+		return cpu >= 0 && cpu < static_cast<int>(t.nodeOfCpu.size()) ? t.nodeOfCpu[cpu] : 0;
+#else
+		return 0;
+#endif
+	}
+
+	bool pinThread(int node)
+	{
+		if (node < 0 || node >= nodes())
+		{
+			return false;
+		}
+#ifdef _WIN32
+		GROUP_AFFINITY affinity;
+		std::memset(&affinity, 0, sizeof(affinity));
+		return GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity) &&
+			SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr);
+#elif defined(__linux__)
+		const Topology& t = topology();
+		if (t.cpus.empty())
+		{
+			return false;
+		}
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int c : t.cpus[node])
+		{
+			CPU_SET(c, &set);
+		}
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+		return false;
+#endif
+	}
+
+	void unpinThread()
+	{
+#ifdef _WIN32
+		SetThreadAffinityMask(GetCurrentThread(), topology().process);
+#elif defined(__linux__)
+		cpu_set_t set = topology().process;
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+	}
+
+	void interleave(void* p, std::size_t bytes, std::size_t page)
+	{
+		int count = nodes();
+		if (count == 1)
+		{
+			std::memset(p, 0, bytes);
+			return;
+		}
+		if (page == 0)
+		{
+			page = 4096;
+		}
+		// Pages counted from the page boundary at or before p
+		char* first = static_cast<char*>(p);
+		char* last = first + bytes;
+		char* base = first - reinterpret_cast<std::uintptr_t>(first) % page;
+		std::vector<std::thread> touchers;
+		for (int n = 0; n < count; ++n)
+		{
+			touchers.emplace_back([=]()
+			{
+				pinThread(n);
+				for (char* at = base + n * page; at < last; at += count * page)
+				{
+					char* from = std::max(at, first);
+					std::memset(from, 0, std::min(at + page, last) - from);
+				}
+			});
+		}
+		for (auto& t : touchers)
+		{
+			t.join();
+		}
+	}
+}
@@ -0,0 +1,88 @@
+/*
+NUMA topology, thread pinning and page placement.
+
+On a multi-socket machine memory is attached to one node (socket) and is
+slower to reach from the others.  The OS puts a page on the node of the
+thread that first touches it, so a matrix zeroed by one thread ends up
+wholly on that thread's node and every other node pays the remote cost.
+The tools here work with first touch rather than against it, so they
+need nothing beyond the OS thread affinity calls:
+
+	pinThread(node)  - keep the calling thread on the CPUs of node; data
+	                   it then allocates and touches is local to it
+	interleave()     - zero a fresh block with one pinned thread per node,
+	                   page i touched from node i % nodes(), spreading the
+	                   bandwidth of a shared read-mostly block over all
+	                   the memory controllers (Matrix, MatrixMemory::Interleaved)
+	Replicated<T>    - one copy of a read-only object per node, each made
+	                   by a thread on that node; local() is the copy of
+	                   the calling thread's node
+	Executor(threads, true) pins its workers round robin to the nodes
+	(executor.h).
+
+Placement only applies to pages not touched before, i.e. large blocks
+the allocator maps fresh from the OS.  With one node (or no NUMA support)
+everything still works: pinning does nothing and there is one replica.
+*/
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace numa
+{
+	// Nodes of the machine, at least 1
+	int nodes();
+	// Node of the CPU the calling thread is running on
+	int currentNode();
+	// Keep the calling thread on the CPUs of node; false if it cannot be
+	// done, the thread then runs where it did.
+	bool pinThread(int node);
+	// Let the calling thread run on any CPU of the process again
+	void unpinThread();
+
+	// Zero [p, p + bytes) page by page, page i from a thread pinned to
+	// node i % nodes(); page is the placement granularity (the huge page
+	// size for blocks backed by huge pages).
+	void interleave(void* p, std::size_t bytes, std::size_t page);
+
+	// Run f on a thread pinned to node and wait for it
+	template <class F>
+	void runOn(int node, F f)
+	{
+		std::thread t([node, &f]()
+		{
+			pinThread(node);
+			f();
+		});
+		t.join();
+	}
+
+	// Replicated ADT
+	// Copies are made once and never modified, so any thread may read any
+	// of them.  A copy is allocated like its master: replicate a graph
+	// whose matrix is not Interleaved, or every copy is spread out again.
+	template <class T>
+	class Replicated
+	{
+	private:
+		std::vector<std::unique_ptr<const T>> m_copies;
+	public:
+		explicit Replicated(const T& master)
+		{
+			int count = nodes();
+			m_copies.resize(count);
+			for (int n = 0; n < count; ++n)
+			{
+				runOn(n, [this, n, &master]()
+				{
+					m_copies[n].reset(new T(master));
+				});
+			}
+		}
+		int copies() const { return static_cast<int>(m_copies.size()); };
+		const T& on(int node) const { return *m_copies[node % copies()]; };
+		const T& local() const { return on(currentNode()); };
+	};
+}
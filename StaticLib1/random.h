@@ -0,0 +1,237 @@
+/*
+Batched random numbers for graph generation and simulation.
+
+RandomStream runs 8 interleaved xoshiro256+ generators, stepped together
+by the core::randomBlocks kernel (one AVX-512 register, two AVX2 or four
+SSE2 registers), and hands out their words from a buffer or straight into
+the caller's array with fill().  The 8 generators are one jump (2^128
+steps) apart, so they never overlap.
+
+A stream is fully determined by (seed, stream): stream s starts s long
+jumps (2^192 steps) from the seed, so threads given the stream numbers
+0, 1, 2... of one seed get independent and reproducible sequences.
+
+Only the high bits of the words are used: they are the strong bits of
+xoshiro256+.  Ints in [lo, hi] come from a multiply and shift of the top
+32 bits, which is biased by at most (hi - lo + 1) / 2^32; doubles in
+[lo, hi) take the top 53 bits.
+
+	RandomStream rng(seed, thread);
+	rng.fill(costs.data(), costs.size(), 1, 10);
+	double p = rng.uniform(0.0, 1.0);
+*/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+#include "kernels.h"
+
+class RandomStream
+{
+private:
+	static const int lanes = 8;
+	// Words per refill of the buffer
+	static const int bufferSize = 64 * lanes;
+
+	alignas(64) std::uint64_t m_state[4 * lanes];
+	alignas(64) std::uint64_t m_buffer[bufferSize];
+	int m_next;
+
+	static std::uint64_t splitmix(std::uint64_t& x)
+	{
+		std::uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	// One step of a single xoshiro256+ generator
+	static void step(std::uint64_t s[4])
+	{
+		std::uint64_t t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = (s[3] << 45) | (s[3] >> 19);
+	}
+
+	// Advance s by the step count the polynomial stands for
+	static void jump(std::uint64_t s[4], const std::uint64_t polynomial[4])
+	{
+		std::uint64_t j[4] = { 0, 0, 0, 0 };
+		for (int w = 0; w < 4; ++w)
+		{
+			for (int b = 0; b < 64; ++b)
+			{
+				if (polynomial[w] & (1ull << b))
+				{
+					for (int k = 0; k < 4; ++k)
+					{
+						j[k] ^= s[k];
+					}
+				}
+				step(s);
+			}
+		}
+		for (int k = 0; k < 4; ++k)
+		{
+			s[k] = j[k];
+		}
+	}
+
+	void refill()
+	{
+		core::randomBlocks(m_state, m_buffer, bufferSize / lanes);
+		m_next = 0;
+	}
+
+public:
+	explicit RandomStream(std::uint64_t seed, std::uint64_t stream = 0) : m_next(bufferSize)
+	{
+		static const std::uint64_t jump128[4] = {
+			0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull };
+		static const std::uint64_t jump192[4] = {
+			0x76E15D3EFEFDCBBFull, 0xC5004E441C522FB3ull, 0x77710069854EE241ull, 0x39109BB02ACBE635ull };
+		std::uint64_t s[4];
+		for (int k = 0; k < 4; ++k)
+		{
+			s[k] = splitmix(seed);
+		}
+		for (std::uint64_t i = 0; i < stream; ++i)
+		{
+			jump(s, jump192);
+		}
+		for (int l = 0; l < lanes; ++l)
+		{
+			for (int k = 0; k < 4; ++k)
+			{
+				m_state[k * lanes + l] = s[k];
+			}
+			jump(s, jump128);
+		}
+	}
+
+	// A seed from the OS entropy source
+	static std::uint64_t deviceSeed()
+	{
+		std::random_device rd;
+		return (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+	}
+
+	std::uint64_t next()
+	{
+		if (m_next == bufferSize)
+		{
+			refill();
+		}
+		return m_buffer[m_next++];
+	}
+
+	// Same words, in the same order, as n calls of next()
+	void fill(std::uint64_t* out, std::size_t n)
+	{
+		while (n > 0 && m_next < bufferSize)
+		{
+			*out++ = m_buffer[m_next++];
+			--n;
+		}
+		std::size_t blocks = n / lanes;
+		while (blocks > 0)
+		{
+			int chunk = blocks > (1u << 20) ? (1 << 20) : static_cast<int>(blocks);
+			core::randomBlocks(m_state, out, chunk);
+			out += static_cast<std::size_t>(chunk) * lanes;
+			n -= static_cast<std::size_t>(chunk) * lanes;
+			blocks -= chunk;
+		}
+		for (; n > 0; --n)
+		{
+			*out++ = next();
+		}
+	}
+
+	// Uniform ints in [lo, hi]
+	void fill(int* out, std::size_t n, int lo, int hi)
+	{
+		std::uint64_t range = static_cast<std::uint64_t>(static_cast<std::int64_t>(hi) - lo) + 1;
+		std::uint64_t words[bufferSize];
+		while (n > 0)
+		{
+			std::size_t chunk = n < static_cast<std::size_t>(bufferSize) ? n : bufferSize;
+			fill(words, chunk);
+			for (std::size_t i = 0; i < chunk; ++i)
+			{
+				out[i] = static_cast<int>(lo + static_cast<std::int64_t>(((words[i] >> 32) * range) >> 32));
+			}
+			out += chunk;
+			n -= chunk;
+		}
+	}
+
+	// Uniform doubles in [lo, hi)
+	void fill(double* out, std::size_t n, double lo, double hi)
+	{
+		double scale = (hi - lo) / 9007199254740992.0;
+		std::uint64_t words[bufferSize];
+		while (n > 0)
+		{
+			std::size_t chunk = n < static_cast<std::size_t>(bufferSize) ? n : bufferSize;
+			fill(words, chunk);
+			for (std::size_t i = 0; i < chunk; ++i)
+			{
+				out[i] = lo + static_cast<double>(words[i] >> 11) * scale;
+			}
+			out += chunk;
+			n -= chunk;
+		}
+	}
+
+	int uniform(int lo, int hi)
+	{
+		std::uint64_t range = static_cast<std::uint64_t>(static_cast<std::int64_t>(hi) - lo) + 1;
+		return static_cast<int>(lo + static_cast<std::int64_t>(((next() >> 32) * range) >> 32));
+	}
+
+	double uniform(double lo, double hi)
+	{
+		return lo + static_cast<double>(next() >> 11) * ((hi - lo) / 9007199254740992.0);
+	}
+};
+
+// A random generator to assist with random int and double values.
+// The OS entropy source is read once per process; every instance then
+// takes the next seed of a process wide sequence.
+class Random
+{
+private:
+	RandomStream m_stream;
+
+	static std::uint64_t nextSeed()
+	{
+		static const std::uint64_t base = RandomStream::deviceSeed();
+		static std::atomic<std::uint64_t> counter(0);
+		return base + 0x9E3779B97F4A7C15ull * counter++;
+	}
+
+public:
+	Random() : m_stream(nextSeed()) {};
+	// Reproducible: the same (seed, stream) gives the same values
+	explicit Random(std::uint64_t seed, std::uint64_t stream = 0) : m_stream(seed, stream) {};
+
+	double getRandom(double start, double end)
+	{
+		return m_stream.uniform(start, end);
+	}
+
+	int getRandom(int start, int end)
+	{
+		return m_stream.uniform(start, end);
+	}
+
+	// Batched access for the hot loops
+	RandomStream& stream() { return m_stream; };
+};
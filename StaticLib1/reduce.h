@@ -0,0 +1,202 @@
+/*
+Reductions over contiguous data.
+
+The sum/subtract templates in sb_01.cpp copy their vector argument and
+add through a single accumulator, so every addition waits for the one
+before it.  The functions here take a Span (pointer + size, no copy) and:
+
+	sum         - 8 independent accumulators; the compiler keeps them in
+	              vector registers and the additions pipeline
+	kahanSum    - compensated (Neumaier) summation, for floating point
+	              data where the rounding error of a plain sum matters
+	pairwiseSum - recursive halving down to blocks summed with sum();
+	              error grows with log(n) rather than n, at nearly the
+	              speed of sum()
+	parallelSum - splits the span into chunks summed on separate threads
+	              with any of the above, then combines the partial sums
+	sumExcluding - sum() into a wider accumulator type, leaving out a
+	              marker value such as INT_MAX for "no cost"
+
+Integer sums use the element type as the accumulator, as before.
+*/
+#pragma once
+#include <cstddef>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace reduce
+{
+	// Read only view of contiguous elements
+	template <class T>
+	class Span
+	{
+	private:
+		const T* m_data;
+		std::size_t m_size;
+	public:
+		Span(const T* data, std::size_t size) : m_data(data), m_size(size) {};
+		Span(const std::vector<T>& v) : m_data(v.data()), m_size(v.size()) {};
+		template <std::size_t N>
+		Span(const T(&a)[N]) : m_data(a), m_size(N) {};
+
+		const T* data() const { return m_data; };
+		std::size_t size() const { return m_size; };
+		const T* begin() const { return m_data; };
+		const T* end() const { return m_data + m_size; };
+		const T& operator[](std::size_t i) const { return m_data[i]; };
+		Span subspan(std::size_t first, std::size_t count) const { return Span(m_data + first, count); };
+	};
+
+	template <class T>
+	Span<T> span(const std::vector<T>& v)
+	{
+		return Span<T>(v);
+	}
+
+	enum class Summation
+	{
+		Fast,
+		Kahan,
+		Pairwise
+	};
+
+	template <class T>
+	T sum(Span<T> s)
+	{
+		const int lanes = 8;
+		T acc[lanes] = {};
+		const T* p = s.data();
+		std::size_t n = s.size();
+		std::size_t i = 0;
+		for (; i + lanes <= n; i += lanes)
+		{
+			for (int k = 0; k < lanes; ++k)
+			{
+				acc[k] += p[i + k];
+			}
+		}
+		for (; i < n; ++i)
+		{
+			acc[0] += p[i];
+		}
+		return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+	}
+
+	// e.g. sumExcluding<long long>(costs, INT_MAX)
+	template <class Acc, class T>
+	Acc sumExcluding(Span<T> s, T skip)
+	{
+		const int lanes = 8;
+		Acc acc[lanes] = {};
+		const T* p = s.data();
+		std::size_t n = s.size();
+		std::size_t i = 0;
+		for (; i + lanes <= n; i += lanes)
+		{
+			for (int k = 0; k < lanes; ++k)
+			{
+				acc[k] += p[i + k] != skip ? static_cast<Acc>(p[i + k]) : Acc{};
+			}
+		}
+		for (; i < n; ++i)
+		{
+			acc[0] += p[i] != skip ? static_cast<Acc>(p[i]) : Acc{};
+		}
+		return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+	}
+
+	template <class T>
+	T kahanSum(Span<T> s)
+	{
+		T total{};
+		T compensation{};
+		for (const T& x : s)
+		{
+			T t = total + x;
+			// Recover the low order bits lost by whichever operand is smaller
+			if ((total < 0 ? -total : total) >= (x < 0 ? -x : x))
+			{
+				compensation += (total - t) + x;
+			}
+			else
+			{
+				compensation += (x - t) + total;
+			}
+			total = t;
+		}
+		return total + compensation;
+	}
+
+	template <class T>
+	T pairwiseSum(Span<T> s)
+	{
+		const std::size_t block = 256;
+		if (s.size() <= block)
+		{
+			return sum(s);
+		}
+		std::size_t half = s.size() / 2;
+		return pairwiseSum(s.subspan(0, half)) + pairwiseSum(s.subspan(half, s.size() - half));
+	}
+
+	template <class T>
+	T sum(Span<T> s, Summation method)
+	{
+		switch (method)
+		{
+		case Summation::Kahan:
+			return kahanSum(s);
+		case Summation::Pairwise:
+			return pairwiseSum(s);
+		default:
+			return sum(s);
+		}
+	}
+
+	// threads = 0 uses one thread per hardware thread; spans shorter than
+	// minChunk per thread are summed on fewer threads.
+	template <class T>
+	T parallelSum(Span<T> s, Summation method = Summation::Fast,
+		unsigned threads = 0, std::size_t minChunk = 1 << 16)
+	{
+		if (threads == 0)
+		{
+			threads = std::thread::hardware_concurrency();
+		}
+		std::size_t chunks = s.size() / (minChunk ? minChunk : 1);
+		if (chunks > threads)
+		{
+			chunks = threads;
+		}
+		if (chunks <= 1)
+		{
+			return sum(s, method);
+		}
+
+		std::vector<std::future<T>> parts;
+		std::size_t first = 0;
+		for (std::size_t c = 0; c + 1 < chunks; ++c)
+		{
+			std::size_t end = s.size() * (c + 1) / chunks;
+			Span<T> part = s.subspan(first, end - first);
+			parts.push_back(std::async(std::launch::async, [part, method]() { return sum(part, method); }));
+			first = end;
+		}
+		// The calling thread sums the last chunk while the others run
+		T last = sum(s.subspan(first, s.size() - first), method);
+		std::vector<T> partial;
+		for (auto& p : parts)
+		{
+			partial.push_back(p.get());
+		}
+		partial.push_back(last);
+		return sum(Span<T>(partial), method);
+	}
+
+	template <class T>
+	T subtract(Span<T> s, T start = T())
+	{
+		return start - sum(s);
+	}
+}
@@ -0,0 +1,197 @@
+/*
+Vertex reordering for the matrix graphs.
+
+Vertex ids are whatever the generator or the data file assigned, so the
+neighbors of a vertex are scattered across the matrix rows and the
+distance/visited arrays.  A reordering pass renumbers the vertices so that
+vertices which are adjacent get ids which are close together.  The
+Permutation keeps both directions of the mapping so callers can keep using
+the original (external) ids.
+
+Works with any matrix type supporting m[i][j].
+*/
+#pragma once
+#include <algorithm>
+#include <string>
+#include <vector>
+
+enum class Ordering
+{
+	None,
+	// Breadth first from a minimum degree vertex, neighbors visited in
+	// increasing degree, then reversed (Reverse Cuthill-McKee).
+	CuthillMcKee,
+	// Highest degree first so that the hub rows are packed together.
+	Degree
+};
+
+// "cm", "degree" or "none"; false for any other name
+inline bool parseOrdering(const std::string& name, Ordering& order)
+{
+	if (name == "cm")
+	{
+		order = Ordering::CuthillMcKee;
+	}
+	else if (name == "degree")
+	{
+		order = Ordering::Degree;
+	}
+	else if (name == "none")
+	{
+		order = Ordering::None;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+// Permutation ADT
+// m_order[new] = old and m_rank[old] = new.  An empty permutation is the
+// identity.
+class Permutation
+{
+private:
+	std::vector<int> m_order;
+	std::vector<int> m_rank;
+
+public:
+	Permutation() {};
+	explicit Permutation(std::vector<int> order) : m_order(order)
+	{
+		m_rank.resize(m_order.size());
+		for (int i = 0; i < static_cast<int>(m_order.size()); ++i)
+		{
+			m_rank[m_order[i]] = i;
+		}
+	}
+	bool empty() const { return m_order.empty(); };
+	int toNew(int v) const { return m_rank.empty() ? v : m_rank[v]; };
+	int toOld(int v) const { return m_order.empty() ? v : m_order[v]; };
+
+	// Apply p on top of this permutation (old -> this -> p).
+	Permutation then(const Permutation& p) const
+	{
+		if (empty())
+		{
+			return p;
+		}
+		std::vector<int> order(m_order.size());
+		for (int i = 0; i < static_cast<int>(order.size()); ++i)
+		{
+			order[i] = toOld(p.toOld(i));
+		}
+		return Permutation(order);
+	}
+};
+
+// Number of distinct neighbors of every vertex, ignoring edge direction.
+template <class Matrix>
+std::vector<int> undirectedDegrees(const Matrix& m, int size)
+{
+	std::vector<int> degree(size, 0);
+	for (int i = 0; i < size; ++i)
+	{
+		for (int j = 0; j < size; ++j)
+		{
+			if (i != j && (m[i][j] || m[j][i]))
+			{
+				++degree[i];
+			}
+		}
+	}
+	return degree;
+}
+
+template <class Matrix>
+Permutation cuthillMcKee(const Matrix& m, int size)
+{
+	std::vector<int> degree = undirectedDegrees(m, size);
+	std::vector<int> order;
+	std::vector<int> next;
+	std::vector<bool> placed(size, false);
+	order.reserve(size);
+
+	auto byDegree = [&degree](int a, int b) { return degree[a] < degree[b]; };
+
+	while (static_cast<int>(order.size()) < size)
+	{
+		// Each component starts at its lowest degree vertex.
+		int start = -1;
+		for (int i = 0; i < size; ++i)
+		{
+			if (!placed[i] && (start < 0 || degree[i] < degree[start]))
+			{
+				start = i;
+			}
+		}
+		placed[start] = true;
+		order.push_back(start);
+
+		for (std::size_t head = order.size() - 1; head < order.size(); ++head)
+		{
+			int v = order[head];
+			next.clear();
+			for (int j = 0; j < size; ++j)
+			{
+				if (!placed[j] && (m[v][j] || m[j][v]))
+				{
+					placed[j] = true;
+					next.push_back(j);
+				}
+			}
+			std::stable_sort(next.begin(), next.end(), byDegree);
+			order.insert(order.end(), next.begin(), next.end());
+		}
+	}
+	std::reverse(order.begin(), order.end());
+	return Permutation(order);
+}
+
+template <class Matrix>
+Permutation degreeOrder(const Matrix& m, int size)
+{
+	std::vector<int> degree = undirectedDegrees(m, size);
+	std::vector<int> order(size);
+	for (int i = 0; i < size; ++i)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(),
+		[&degree](int a, int b) { return degree[a] > degree[b]; });
+	return Permutation(order);
+}
+
+template <class Matrix>
+Permutation ordering(const Matrix& m, int size, Ordering o)
+{
+	switch (o)
+	{
+	case Ordering::CuthillMcKee:
+		return cuthillMcKee(m, size);
+	case Ordering::Degree:
+		return degreeOrder(m, size);
+	default:
+		return Permutation();
+	}
+}
+
+// Renumber the rows and columns of m: new m[i][j] = old m[p(i)][p(j)]
+template <class Matrix>
+void permute(Matrix& m, int size, const Permutation& p)
+{
+	if (p.empty())
+	{
+		return;
+	}
+	Matrix old = m;
+	for (int i = 0; i < size; ++i)
+	{
+		int oi = p.toOld(i);
+		for (int j = 0; j < size; ++j)
+		{
+			m[i][j] = old[oi][p.toOld(j)];
+		}
+	}
+}
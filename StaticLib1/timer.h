@@ -0,0 +1,31 @@
+/*
+Wall clock timer shared by the graph programs.
+*/
+#pragma once
+#include <chrono>
+
+// Though not part of the assignment, the following class implements a Timer,
+// allowing you to check the runtime execution of the implementation.
+// Credit: http://www.learncpp.com/cpp-tutorial/8-16-timing-your-code/
+class Timer
+{
+private:
+	using clock_t = std::chrono::high_resolution_clock;
+	using second_t = std::chrono::duration<double, std::ratio<1>>;
+
+	std::chrono::time_point<clock_t> m_beg;
+
+public:
+	Timer() : m_beg(clock_t::now())
+	{}
+
+	void reset()
+	{
+		m_beg = clock_t::now();
+	}
+
+	double elapsed() const
+	{
+		return std::chrono::duration_cast<second_t>(clock_t::now() - m_beg).count();
+	}
+};
@@ -0,0 +1,281 @@
+// Need the following as the first include for a Visual Studio environment
+#include "stdafx.h"
+
+/*
+Per thread event buffers, clock calibration and export for trace.h.
+*/
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define TRACE_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TRACE_TSC 1
+#endif
+
+namespace trace
+{
+	namespace
+	{
+		using steady = std::chrono::steady_clock;
+
+		struct Event
+		{
+			const char* name;
+			std::uint64_t start;
+			std::uint64_t end;
+		};
+
+		// Written only by its thread; count is published with release so
+		// an exporter sees complete events.
+		struct Buffer
+		{
+			std::vector<Event> events;
+			std::atomic<std::uint64_t> count;
+			int thread;
+			// Events below this count were cleared; guarded by the registry lock
+			std::uint64_t floor;
+
+			explicit Buffer(int t) : events(bufferEvents), count(0), thread(t), floor(0) {};
+		};
+
+		struct Registry
+		{
+			std::mutex lock;
+			// Kept after their threads exit so their events can be exported
+			std::vector<std::shared_ptr<Buffer>> buffers;
+			std::uint64_t originTicks;
+			steady::time_point originTime;
+
+			Registry() : originTicks(now()), originTime(steady::now()) {};
+		};
+
+		Registry& registry()
+		{
+			static Registry r;
+			return r;
+		}
+
+		Buffer& threadBuffer()
+		{
+			thread_local std::shared_ptr<Buffer> buffer;
+			if (!buffer)
+			{
+				Registry& r = registry();
+				std::lock_guard<std::mutex> guard(r.lock);
+				buffer = std::make_shared<Buffer>(static_cast<int>(r.buffers.size()) + 1);
+				r.buffers.push_back(buffer);
+			}
+			return *buffer;
+		}
+
+		// Ticks per microsecond, measured against steady_clock since the
+		// registry was created (at least 10ms, so the rate is accurate).
+		double ticksPerMicrosecond(Registry& r)
+		{
+			steady::time_point t;
+			while ((t = steady::now()) - r.originTime < std::chrono::milliseconds(10))
+			{
+				std::this_thread::yield();
+			}
+			std::uint64_t ticks = now() - r.originTicks;
+			double us = std::chrono::duration<double, std::micro>(t - r.originTime).count();
+			return ticks / us;
+		}
+
+		// An event in microseconds since the registry was created
+		struct Span
+		{
+			const char* name;
+			int thread;
+			double start;
+			double duration;
+		};
+
+		std::vector<Span> collect()
+		{
+			Registry& r = registry();
+			double rate = ticksPerMicrosecond(r);
+			std::vector<Span> spans;
+			std::lock_guard<std::mutex> guard(r.lock);
+			for (auto& b : r.buffers)
+			{
+				std::uint64_t count = b->count.load(std::memory_order_acquire);
+				std::uint64_t first = count > static_cast<std::uint64_t>(bufferEvents) ? count - bufferEvents : 0;
+				first = std::max(first, b->floor);
+				for (std::uint64_t i = first; i < count; ++i)
+				{
+					const Event& e = b->events[i & (bufferEvents - 1)];
+					double start = e.start > r.originTicks ? (e.start - r.originTicks) / rate : 0.0;
+					double duration = e.end > e.start ? (e.end - e.start) / rate : 0.0;
+					spans.push_back(Span{ e.name, b->thread, start, duration });
+				}
+			}
+			std::sort(spans.begin(), spans.end(), [](const Span& a, const Span& b) { return a.start < b.start; });
+			return spans;
+		}
+
+		void writeString(std::ostream& out, const char* s)
+		{
+			out << '"';
+			for (; *s; ++s)
+			{
+				if (*s == '"' || *s == '\\')
+				{
+					out << '\\';
+				}
+				out << *s;
+			}
+			out << '"';
+		}
+	}
+
+	void enable(bool on)
+	{
+		// Fix the time origin before the first event
+		registry();
+		enabledFlag().store(on, std::memory_order_relaxed);
+	}
+
+	std::uint64_t now()
+	{
+#ifdef TRACE_TSC
+		return __rdtsc();
+#else
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			steady::now().time_since_epoch()).count());
+#endif
+	}
+
+	void record(const char* name, std::uint64_t start, std::uint64_t end)
+	{
+		Buffer& b = threadBuffer();
+		std::uint64_t count = b.count.load(std::memory_order_relaxed);
+		b.events[count & (bufferEvents - 1)] = Event{ name, start, end };
+		b.count.store(count + 1, std::memory_order_release);
+	}
+
+	void clear()
+	{
+		Registry& r = registry();
+		std::lock_guard<std::mutex> guard(r.lock);
+		for (auto& b : r.buffers)
+		{
+			b->floor = b->count.load(std::memory_order_acquire);
+		}
+	}
+
+	void writeChromeTrace(std::ostream& out)
+	{
+		std::vector<Span> spans = collect();
+		std::ios::fmtflags flags = out.flags();
+		std::streamsize precision = out.precision();
+		out.setf(std::ios::fixed, std::ios::floatfield);
+		out.precision(3);
+
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		std::vector<int> threads;
+		for (auto& s : spans)
+		{
+			if (std::find(threads.begin(), threads.end(), s.thread) == threads.end())
+			{
+				threads.push_back(s.thread);
+			}
+		}
+		bool first = true;
+		for (int t : threads)
+		{
+			out << (first ? "\n" : ",\n");
+			out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t;
+			out << ",\"args\":{\"name\":\"thread " << t << "\"}}";
+			first = false;
+		}
+		for (auto& s : spans)
+		{
+			out << (first ? "\n" : ",\n") << "{\"name\":";
+			writeString(out, s.name);
+			out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << s.thread;
+			out << ",\"ts\":" << s.start << ",\"dur\":" << s.duration << "}";
+			first = false;
+		}
+		out << "\n]}\n";
+
+		out.flags(flags);
+		out.precision(precision);
+	}
+
+	void writeHistograms(std::ostream& out)
+	{
+		std::map<std::string, std::vector<double>> phases;
+		for (auto& s : collect())
+		{
+			phases[s.name].push_back(s.duration);
+		}
+
+		std::ios::fmtflags flags = out.flags();
+		std::streamsize precision = out.precision();
+		out.setf(std::ios::fixed, std::ios::floatfield);
+		out.precision(1);
+
+		out << "Phase latencies (us):\n";
+		for (auto& phase : phases)
+		{
+			std::vector<double>& d = phase.second;
+			std::sort(d.begin(), d.end());
+			double total = 0;
+			for (double x : d)
+			{
+				total += x;
+			}
+			auto percentile = [&d](double p)
+			{
+				std::size_t i = static_cast<std::size_t>(std::ceil(p * d.size()));
+				return d[i > 0 ? i - 1 : 0];
+			};
+			out << phase.first << ": " << d.size() << " calls, total " << total;
+			out << ", mean " << total / d.size() << ", p50 " << percentile(0.5);
+			out << ", p90 " << percentile(0.9) << ", p99 " << percentile(0.99);
+			out << ", max " << d.back() << '\n';
+
+			// Bucket 0 is [0, 1us), bucket b is [2^(b-1), 2^b) us
+			std::vector<std::size_t> buckets;
+			for (double x : d)
+			{
+				std::size_t b = 0;
+				for (double bound = 1; x >= bound; bound *= 2)
+				{
+					++b;
+				}
+				if (b >= buckets.size())
+				{
+					buckets.resize(b + 1, 0);
+				}
+				++buckets[b];
+			}
+			out << " ";
+			for (std::size_t b = 0; b < buckets.size(); ++b)
+			{
+				if (buckets[b])
+				{
+					out << " <" << (1ull << b) << "us: " << buckets[b];
+				}
+			}
+			out << '\n';
+		}
+
+		out.flags(flags);
+		out.precision(precision);
+	}
+}
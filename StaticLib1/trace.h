@@ -0,0 +1,88 @@
+/*
+Scoped tracing of the program phases.
+
+	void Graph::generate()
+	{
+		TRACE_SCOPE("generate");
+		...
+	}
+
+records one event (name, start, end) per call while tracing is enabled.
+Recording is off until trace::enable(true); a closed scope then costs
+one flag load.
+
+Timestamps are CPU time stamp counter ticks (std::chrono::steady_clock
+where there is none), converted to microseconds only when exported.
+Each thread writes to its own ring buffer of bufferEvents events, with no
+locks or shared writes; a thread registers its buffer on its first event
+and the oldest events are overwritten when it is full.
+
+At the end of a run the events are written as Chrome trace JSON (load it
+in chrome://tracing or Perfetto) or as per-phase latency histograms.
+Export while other threads are still recording may miss their newest
+events.
+
+Event names must be string literals or otherwise outlive the export.
+*/
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+
+namespace trace
+{
+	// Events kept per thread, a power of 2
+	const int bufferEvents = 1 << 16;
+
+	inline std::atomic<bool>& enabledFlag()
+	{
+		static std::atomic<bool> enabled(false);
+		return enabled;
+	}
+
+	inline bool enabled()
+	{
+		return enabledFlag().load(std::memory_order_relaxed);
+	}
+
+	void enable(bool on);
+
+	// Current time in ticks
+	std::uint64_t now();
+
+	// Add an event to the calling thread's buffer
+	void record(const char* name, std::uint64_t start, std::uint64_t end);
+
+	// Drop the events recorded so far
+	void clear();
+
+	// All buffered events as a Chrome trace event file
+	void writeChromeTrace(std::ostream& out);
+
+	// For each event name: count, total, percentiles and a log2 histogram
+	// of the durations
+	void writeHistograms(std::ostream& out);
+
+	// Records the lifetime of the scope
+	class Scope
+	{
+	private:
+		const char* m_name;
+		std::uint64_t m_start;
+	public:
+		explicit Scope(const char* name) : m_name(enabled() ? name : nullptr), m_start(m_name ? now() : 0) {};
+		~Scope()
+		{
+			if (m_name)
+			{
+				record(m_name, m_start, now());
+			}
+		}
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
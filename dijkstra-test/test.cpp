@@ -1,5 +1,66 @@
 #include "pch.h" 
+// The test build always has the solver counters compiled in
+#define GRAPH_STATS
 #include "..\dijkstra\dijkstra.h"
+#include "..\dijkstra\graph.h"
+#include "..\dijkstra\path_cache.h"
+#include "..\dijkstra\components.h"
+#include "..\dijkstra\kpaths.h"
+#include "..\dijkstra\tree_store.h"
+#include "..\dijkstra\oracle.h"
+#include "..\dijkstra\snapshot.h"
+#include "..\StaticLib1\matrix.h"
+#include "..\StaticLib1\matrix_graph.h"
+#include "..\StaticLib1\reduce.h"
+#include "..\StaticLib1\kernels.h"
+#include "..\StaticLib1\random.h"
+#include "..\StaticLib1\footprint.h"
+#include "..\StaticLib1\numa.h"
+#include "..\StaticLib1\generators.h"
+#include "..\StaticLib1\graph_io.h"
+#include "..\loadgen\histogram.h"
+#include "..\loadgen\workload.h"
+#include "..\shardsp\shard.h"
+#include "..\mst\kruskal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <new>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+// Count heap allocations so that tests can check a hot path does not
+// allocate.  Atomic as the executor tests allocate on worker threads.
+static std::atomic<std::size_t> g_allocations{ 0 };
+
+void* operator new(std::size_t size)
+{
+	++g_allocations;
+	if (void* p = std::malloc(size ? size : 1))
+	{
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
 
 namespace {
 
@@ -22,6 +83,47 @@ namespace {
 		EXPECT_GT(1.0, r.getRandom(0.1, 1.0));
 	};
 
+	// The same seed and stream give the same values, other streams differ
+	TEST(RandomTest, StreamsReproducible)
+	{
+		Random a(42, 3), b(42, 3), c(42, 4), d(43, 3);
+		int same = 0, other = 0;
+		for (int i = 0; i < 1000; ++i)
+		{
+			std::uint64_t x = a.stream().next();
+			EXPECT_EQ(x, b.stream().next());
+			same += x == c.stream().next();
+			other += x == d.stream().next();
+		}
+		EXPECT_EQ(0, same);
+		EXPECT_EQ(0, other);
+	};
+
+	// Batches hold the same sequence as single draws and stay in range
+	TEST(RandomTest, FillMatchesNext)
+	{
+		RandomStream a(7), b(7);
+		std::vector<std::uint64_t> words(5000);
+		a.next();
+		a.fill(words.data(), words.size());
+		b.next();
+		for (std::uint64_t w : words)
+		{
+			EXPECT_EQ(b.next(), w);
+		}
+
+		std::vector<int> ints(3001);
+		a.fill(ints.data(), ints.size(), -3, 3);
+		EXPECT_EQ(-3, *std::min_element(ints.begin(), ints.end()));
+		EXPECT_EQ(3, *std::max_element(ints.begin(), ints.end()));
+		std::vector<double> doubles(3001);
+		a.fill(doubles.data(), doubles.size(), 0.5, 1.5);
+		EXPECT_LE(0.5, *std::min_element(doubles.begin(), doubles.end()));
+		EXPECT_GT(1.5, *std::max_element(doubles.begin(), doubles.end()));
+		double mean = std::accumulate(doubles.begin(), doubles.end(), 0.0) / doubles.size();
+		EXPECT_NEAR(1.0, mean, 0.05);
+	};
+
 	// Fixture class for the Vertex ADT
 	class VertexTest : public ::testing::Test
 	{
@@ -53,7 +155,7 @@ namespace {
 	{
 		int id = 10;
 		Vertex v{ id };
-		std::vector<Edge> list = v.neighbors();
+		std::vector<int> list = v.neighbors();
 		EXPECT_EQ(0, list.size());
 	}
 
@@ -125,6 +227,1682 @@ namespace {
 		EXPECT_EQ(size, g.vertices());
 		EXPECT_EQ(density, g.getDensity());
 	}
+
+	// Test the edge lookups on a graph built from an edge list
+	TEST(GraphTest, GraphBuildEdgeLookup)
+	{
+		Graph g{ 4 };
+		g.build({ Edge(2, 3, 7), Edge(0, 2, 5), Edge(0, 1, 3), Edge(1, 1, 9), Edge(0, 2, 8) });
+		// The loop and the duplicate are dropped
+		EXPECT_EQ(3, g.edges());
+		EXPECT_EQ(2, g.degree(0));
+		EXPECT_EQ(0, g.degree(1));
+		EXPECT_EQ(1, g.degree(2));
+		EXPECT_EQ(3, g.edgeCost(0, 1));
+		EXPECT_EQ(5, g.edgeCost(0, 2));
+		EXPECT_EQ(0, g.edgeCost(2, 0));
+		EXPECT_TRUE(g.adjacent(Vertex(2), Vertex(3)));
+		EXPECT_FALSE(g.adjacent(Vertex(3), Vertex(2)));
+		std::vector<int> expected{ 1, 2 };
+		IdRange ids = g.neighbors(Vertex(0));
+		EXPECT_EQ(expected, std::vector<int>(ids.begin(), ids.end()));
+	}
+
+	// Test the degrees of a generated graph add up to the edge count
+	TEST(GraphTest, GraphGenerateDegrees)
+	{
+		Graph g{ 50, 0.3 };
+		g.generate();
+		int total = 0;
+		for (int v = 0; v < g.vertices(); ++v)
+		{
+			total += g.degree(v);
+			for (auto n : g.neighbors(Vertex(v)))
+			{
+				EXPECT_NE(v, n);
+				EXPECT_LE(1, g.edgeCost(v, n));
+				EXPECT_GE(10, g.edgeCost(v, n));
+			}
+		}
+		EXPECT_EQ(g.edges(), total);
+	}
+
+	// Fixture class for the ShortestPath ADT
+	class ShortestPathTest : public ::testing::Test
+	{
+	};
+
+	// Test the cheapest route is found over a more direct edge
+	TEST(ShortestPathTest, PathCost)
+	{
+		Graph g{ 5 };
+		g.build({ Edge(0, 1, 4), Edge(0, 2, 1), Edge(2, 1, 2), Edge(1, 3, 1) });
+		ShortestPath sp(std::move(g));
+		EXPECT_TRUE(sp.path(Vertex(0), Vertex(3)));
+		EXPECT_EQ(4, sp.pathCost());
+		EXPECT_EQ(3, sp.pathCost(Vertex(1)));
+		EXPECT_FALSE(sp.path(Vertex(0), Vertex(4)));
+		EXPECT_FALSE(sp.path(Vertex(3), Vertex(0)));
+	}
+
+	// Test several solvers can share one graph
+	TEST(ShortestPathTest, SharedGraph)
+	{
+		auto g = std::make_shared<Graph>(3);
+		g->build({ Edge(0, 1, 2), Edge(1, 2, 3) });
+		ShortestPath sp1(g);
+		ShortestPath sp2(g);
+		EXPECT_EQ(&sp1.graph(), &sp2.graph());
+		EXPECT_TRUE(sp1.path(Vertex(0), Vertex(2)));
+		EXPECT_TRUE(sp2.path(Vertex(1), Vertex(2)));
+		EXPECT_EQ(5, sp1.pathCost());
+		EXPECT_EQ(3, sp2.pathCost());
+	}
+
+	// Test the counters of a run on a known graph
+	TEST(ShortestPathTest, PathStats)
+	{
+		Graph g{ 5 };
+		g.build({ Edge(0, 1, 4), Edge(0, 2, 1), Edge(2, 1, 2), Edge(1, 3, 1) });
+		ShortestPath sp(std::move(g));
+		ASSERT_TRUE(sp.path(Vertex(0), Vertex(3)));
+		const SolverStats& stats = sp.stats();
+		EXPECT_EQ(1u, stats.runs);
+		// 0, 2, 1 and 3 are settled; 1 is improved once via 2
+		EXPECT_EQ(4u, stats.verticesSettled);
+		EXPECT_EQ(4u, stats.queuePops);
+		EXPECT_EQ(4u, stats.queuePushes);
+		EXPECT_EQ(1u, stats.decreaseKeys);
+		EXPECT_EQ(4u, stats.relaxations);
+		EXPECT_EQ(4u, stats.edgesScanned);
+		EXPECT_LT(0u, stats.bytesTouched);
+	}
+
+	// Test the counters of other threads are merged when they exit
+	TEST(ShortestPathTest, ThreadStatsAggregate)
+	{
+		auto g = std::make_shared<Graph>(3);
+		g->build({ Edge(0, 1, 2), Edge(1, 2, 3) });
+		flushThreadStats();
+		unsigned long long before = processStats().runs;
+		std::thread worker([g]()
+		{
+			ShortestPath sp(g);
+			for (int i = 0; i < 10; ++i)
+			{
+				sp.path(Vertex(0), Vertex(2));
+			}
+			EXPECT_EQ(10u, currentThreadStats().runs);
+		});
+		worker.join();
+		EXPECT_EQ(before + 10, processStats().runs);
+		EXPECT_EQ(0u, currentThreadStats().runs);
+	}
+
+	// Test a query on a constructed solver makes no heap allocations
+	TEST(ShortestPathTest, PathDoesNotAllocate)
+	{
+		Graph g{ 60, 0.3 };
+		g.generate();
+		ShortestPath sp(std::move(g));
+
+		std::size_t before = g_allocations;
+		for (int dst = 1; dst < sp.vertices(); ++dst)
+		{
+			sp.path(Vertex(0), Vertex(dst));
+			sp.graph().neighbors(Vertex(dst));
+			sp.graph().adjacent(Vertex(0), Vertex(dst));
+		}
+		std::size_t allocations = g_allocations - before;
+		EXPECT_EQ(0u, allocations);
+	}
+
+	// Fixture class for the templated graph
+	class GraphTemplateTest : public ::testing::Test
+	{
+	};
+
+	// Small undirected road map, solved by the compiler
+	constexpr graph::Graph<int, false, graph::Fixed<5>> makeFixedGraph()
+	{
+		graph::Graph<int, false, graph::Fixed<5>> g;
+		g.addEdge(0, 1, 4);
+		g.addEdge(0, 2, 1);
+		g.addEdge(2, 1, 2);
+		g.addEdge(1, 3, 5);
+		g.addEdge(3, 4, 3);
+		return g;
+	}
+	constexpr auto fixedTable = graph::allPairs(makeFixedGraph());
+	static_assert(fixedTable[0][3] == 8, "distance computed at compile time");
+	static_assert(fixedTable[4][2] == 10, "undirected edges in both directions");
+	static_assert(graph::spanningTreeCost(makeFixedGraph()) == 11, "tree cost at compile time");
+
+	// Test every storage policy gives the same distances as dijkstra.h
+	TEST(GraphTemplateTest, StoragePoliciesAgree)
+	{
+		Graph g{ 40, 0.2 };
+		g.generate();
+		graph::Graph<int, true, graph::Dense> dense(g.vertices());
+		graph::Graph<int, true, graph::Csr> csr(g.vertices());
+		for (int v = 0; v < g.vertices(); ++v)
+		{
+			IdRange ids = g.neighbors(Vertex(v));
+			IdRange costs = g.neighborCosts(Vertex(v));
+			for (int i = 0; i < ids.size(); ++i)
+			{
+				dense.addEdge(v, ids[i], costs[i]);
+				csr.addEdge(v, ids[i], costs[i]);
+			}
+		}
+
+		ShortestPath sp(std::move(g));
+		auto denseDistances = graph::shortestDistances(dense, 0);
+		auto csrDistances = graph::shortestDistances(csr, 0);
+		for (int v = 0; v < sp.vertices(); ++v)
+		{
+			if (sp.path(Vertex(0), Vertex(v)))
+			{
+				EXPECT_EQ(sp.pathCost(), denseDistances[v]);
+				EXPECT_EQ(sp.pathCost(), csrDistances[v]);
+			}
+			else
+			{
+				EXPECT_EQ(std::numeric_limits<int>::max(), denseDistances[v]);
+				EXPECT_EQ(std::numeric_limits<int>::max(), csrDistances[v]);
+			}
+		}
+	}
+
+	// Test removing an edge from the sparse storage
+	TEST(GraphTemplateTest, CsrRemoveEdge)
+	{
+		graph::Graph<double, false, graph::Csr> g(3);
+		g.addEdge(0, 1, 0.5);
+		g.addEdge(1, 2, 1.5);
+		EXPECT_TRUE(g.adjacent(2, 1));
+		g.removeEdge(1, 2);
+		EXPECT_FALSE(g.adjacent(1, 2));
+		EXPECT_FALSE(g.adjacent(2, 1));
+		EXPECT_DOUBLE_EQ(0.5, g.cost(1, 0));
+		EXPECT_DOUBLE_EQ(0.5, graph::spanningTreeCost(g));
+	}
+
+	// Test every component of a disconnected graph gets a tree
+	TEST(GraphTemplateTest, SpanningForest)
+	{
+		graph::Graph<int, false, graph::Csr> g(6);
+		g.addEdge(0, 1, 4);
+		g.addEdge(2, 3, 2);
+		g.addEdge(3, 4, 3);
+		g.addEdge(2, 4, 9);
+		graph::MST<decltype(g)> mst(g);
+		mst.prim();
+		EXPECT_EQ(9, mst.cost());
+		EXPECT_EQ(-1, mst.parent(0));
+		EXPECT_EQ(-1, mst.parent(2));
+		EXPECT_EQ(-1, mst.parent(5));
+		EXPECT_EQ(3, mst.parent(4));
+	}
+
+	// Test the compressed storage holds the same edges as Csr, in a
+	// fraction of the bytes, and the solvers agree over it
+	TEST(GraphTemplateTest, CompressedMatchesCsr)
+	{
+		Graph g{ 300, 0.1 };
+		g.generate();
+		graph::Graph<int, false, graph::Csr> csr(g.vertices());
+		for (int v = 0; v < g.vertices(); ++v)
+		{
+			IdRange ids = g.neighbors(Vertex(v));
+			IdRange costs = g.neighborCosts(Vertex(v));
+			for (int i = 0; i < ids.size(); ++i)
+			{
+				csr.addEdge(v, ids[i], costs[i]);
+			}
+		}
+		// Costs outside 1..15 take the escaped form
+		csr.addEdge(3, 7, 1000);
+		csr.addEdge(5, 9, -2);
+
+		auto compressed = graph::Graph<int, false, graph::Compressed>::copyOf(csr);
+		EXPECT_LT(3 * compressed.memoryBytes(), csr.memoryBytes());
+		for (int v = 0; v < csr.vertices(); ++v)
+		{
+			std::vector<std::pair<int, int>> expected, actual;
+			csr.forEachNeighbor(v, [&expected](int n, int c) { expected.emplace_back(n, c); });
+			compressed.forEachNeighbor(v, [&actual](int n, int c) { actual.emplace_back(n, c); });
+			ASSERT_EQ(expected, actual);
+		}
+		EXPECT_EQ(1000, compressed.cost(7, 3));
+		EXPECT_EQ(-2, compressed.cost(9, 5));
+
+		// Updates in the middle of the stream
+		compressed.addEdge(0, 150, 12);
+		compressed.removeEdge(5, 9);
+		csr.addEdge(0, 150, 12);
+		csr.removeEdge(5, 9);
+		EXPECT_EQ(12, compressed.cost(150, 0));
+		EXPECT_FALSE(compressed.adjacent(9, 5));
+		EXPECT_EQ(graph::spanningTreeCost(csr), graph::spanningTreeCost(compressed));
+		EXPECT_EQ(graph::shortestDistances(csr, 0), graph::shortestDistances(compressed, 0));
+	}
+
+	// Fixture class for the PathCache
+	class PathCacheTest : public ::testing::Test
+	{
+	};
+
+	// Test a result is only returned for the graph version it was made on
+	TEST(PathCacheTest, VersionInvalidation)
+	{
+		PathCache cache;
+		unsigned long long v1 = nextGraphVersion();
+		unsigned long long v2 = nextGraphVersion();
+		CachedPath result;
+		EXPECT_FALSE(cache.lookup(0, 3, v1, result));
+		cache.store(0, 3, v1, CachedPath{ 7, { 0, 2, 3 } });
+		ASSERT_TRUE(cache.lookup(0, 3, v1, result));
+		EXPECT_EQ(7, result.cost);
+		EXPECT_EQ(3u, result.route.size());
+		EXPECT_FALSE(cache.lookup(0, 3, v2, result));
+		cache.purge(v1);
+		EXPECT_FALSE(cache.lookup(0, 3, v1, result));
+
+		PathCache::Metrics m = cache.metrics();
+		EXPECT_EQ(1u, m.hits);
+		EXPECT_EQ(3u, m.misses);
+		EXPECT_EQ(0u, m.entries);
+		EXPECT_EQ(0u, m.bytes);
+	}
+
+	// Test an entry stored without its route does not answer a route query
+	TEST(PathCacheTest, RouteQueryMissesCostOnlyEntry)
+	{
+		PathCache cache;
+		CachedPath result;
+		cache.store(0, 3, 1, CachedPath{ 7, {} });
+		cache.store(0, 4, 1, CachedPath{ INT_MAX, {} });
+		EXPECT_FALSE(cache.lookup(0, 3, 1, result, true));
+		EXPECT_TRUE(cache.lookup(0, 3, 1, result));
+		EXPECT_TRUE(cache.lookup(0, 4, 1, result, true));
+
+		PathCache::Metrics m = cache.metrics();
+		EXPECT_EQ(2u, m.hits);
+		EXPECT_EQ(1u, m.misses);
+	}
+
+	// Test the least recently used entry is evicted first
+	TEST(PathCacheTest, LeastRecentlyUsedEviction)
+	{
+		PathCache cache(2, 1);
+		CachedPath result;
+		cache.store(0, 1, 1, CachedPath{ 1, {} });
+		cache.store(0, 2, 1, CachedPath{ 2, {} });
+		EXPECT_TRUE(cache.lookup(0, 1, 1, result));
+		cache.store(0, 3, 1, CachedPath{ 3, {} });
+		EXPECT_TRUE(cache.lookup(0, 1, 1, result));
+		EXPECT_FALSE(cache.lookup(0, 2, 1, result));
+		EXPECT_TRUE(cache.lookup(0, 3, 1, result));
+		EXPECT_EQ(1u, cache.metrics().evictions);
+	}
+
+	// Test a shard count below one still gives a working cache
+	TEST(PathCacheTest, ClampsShards)
+	{
+		for (int shards : { 0, -3 })
+		{
+			PathCache cache(4, shards);
+			CachedPath result;
+			cache.store(0, 1, 1, CachedPath{ 1, {} });
+			EXPECT_TRUE(cache.lookup(0, 1, 1, result));
+			EXPECT_EQ(1, result.cost);
+		}
+	}
+
+	// Fixture class for the Executor
+	class ExecutorTest : public ::testing::Test
+	{
+	};
+
+	// Test many queries in flight give the same answers as the blocking API
+	TEST(ExecutorTest, PathAsyncMatchesSync)
+	{
+		auto g = std::make_shared<Graph>(60);
+		g->generate();
+		Executor ex(4);
+		std::vector<std::future<PathResult>> results;
+		for (int dst = 0; dst < g->vertices(); ++dst)
+		{
+			results.push_back(pathAsync(ex, g, 0, dst));
+		}
+		ShortestPath sp(g);
+		for (int dst = 0; dst < g->vertices(); ++dst)
+		{
+			PathResult r = results[dst].get();
+			EXPECT_EQ(sp.path(Vertex(0), Vertex(dst)), r.found);
+			EXPECT_EQ(sp.pathCost(), r.cost);
+		}
+	}
+
+	// Test an exception thrown by a task is rethrown by the future
+	TEST(ExecutorTest, SubmitPropagatesException)
+	{
+		Executor ex(1);
+		std::future<int> f = ex.submit([]() -> int { throw std::runtime_error("load failed"); });
+		EXPECT_THROW(f.get(), std::runtime_error);
+		EXPECT_EQ(3, ex.submit([]() { return 3; }).get());
+	}
+
+#ifdef GRAPH_COROUTINES
+	// Coroutine for the tests: starts at once and frees itself when done
+	struct Detached
+	{
+		struct promise_type
+		{
+			Detached get_return_object() { return Detached(); };
+			std::suspend_never initial_suspend() noexcept { return {}; };
+			std::suspend_never final_suspend() noexcept { return {}; };
+			void return_void() {};
+			void unhandled_exception() { std::terminate(); };
+		};
+	};
+
+	Detached awaitQuery(Executor& ex, std::shared_ptr<const Graph> g, int dst, std::promise<PathResult>& result)
+	{
+		result.set_value(co_await awaitPath(ex, std::move(g), 0, dst));
+	}
+
+	Detached awaitFailure(Executor& ex, std::promise<bool>& caught)
+	{
+		try
+		{
+			co_await ex.schedule([]() -> int { throw std::runtime_error("load failed"); });
+			caught.set_value(false);
+		}
+		catch (const std::runtime_error&)
+		{
+			caught.set_value(true);
+		}
+	}
+
+	// Test awaited queries give the same answers as the blocking API, and
+	// a task's exception is rethrown in the awaiting coroutine
+	TEST(ExecutorTest, AwaitPath)
+	{
+		auto g = std::make_shared<Graph>(60);
+		g->generate();
+		Executor ex(4);
+		std::vector<std::promise<PathResult>> results(g->vertices());
+		for (int dst = 0; dst < g->vertices(); ++dst)
+		{
+			awaitQuery(ex, g, dst, results[dst]);
+		}
+		ShortestPath sp(g);
+		for (int dst = 0; dst < g->vertices(); ++dst)
+		{
+			PathResult r = results[dst].get_future().get();
+			EXPECT_EQ(sp.path(Vertex(0), Vertex(dst)), r.found);
+			EXPECT_EQ(sp.pathCost(), r.cost);
+		}
+
+		std::promise<bool> caught;
+		awaitFailure(ex, caught);
+		EXPECT_TRUE(caught.get_future().get());
+	}
+#else
+	// The test project is built as C++20 so the awaitable is covered
+	TEST(ExecutorTest, AwaitPath)
+	{
+		FAIL() << "built without C++20 coroutines";
+	}
+#endif
+
+	// Fixture class for the Components labels
+	class ComponentsTest : public ::testing::Test
+	{
+	};
+
+	// Test the labels of a small graph: a cycle 0 -> 1 -> 2 -> 0 feeding 3,
+	// and a separate edge 5 -> 4
+	TEST(ComponentsTest, KnownGraph)
+	{
+		std::vector<std::vector<int>> m(6, std::vector<int>(6, 0));
+		m[0][1] = m[1][2] = m[2][0] = m[2][3] = m[5][4] = 1;
+		Components c = components(m, 6);
+		EXPECT_EQ(2, c.weakCount());
+		EXPECT_EQ(4, c.strongCount());
+		EXPECT_TRUE(c.mustReach(0, 2));
+		EXPECT_TRUE(c.mayReach(1, 3));
+		EXPECT_FALSE(c.mustReach(1, 3));
+		EXPECT_FALSE(c.mayReach(3, 0));
+		EXPECT_FALSE(c.mayReach(0, 4));
+		EXPECT_TRUE(c.mayReach(5, 4));
+		EXPECT_FALSE(c.mayReach(4, 5));
+	}
+
+	// Test the labels never contradict a search on random sparse graphs
+	TEST(ComponentsTest, AgreesWithSearch)
+	{
+		for (int round = 0; round < 5; ++round)
+		{
+			Graph g{ 40, 0.04 };
+			g.generate();
+			Components c(g.vertices(), [&g](int v, auto&& f)
+			{
+				for (auto n : g.neighbors(Vertex(v)))
+				{
+					f(n);
+				}
+			});
+			ShortestPath sp(std::move(g));
+			int size = sp.vertices();
+			std::vector<std::vector<bool>> reach(size, std::vector<bool>(size));
+			for (int s = 0; s < size; ++s)
+			{
+				for (int d = 0; d < size; ++d)
+				{
+					reach[s][d] = sp.path(Vertex(s), Vertex(d));
+				}
+			}
+			for (int s = 0; s < size; ++s)
+			{
+				for (int d = 0; d < size; ++d)
+				{
+					if (!c.mayReach(s, d))
+					{
+						EXPECT_FALSE(reach[s][d]);
+					}
+					EXPECT_EQ(reach[s][d] && reach[d][s], c.mustReach(s, d));
+				}
+			}
+		}
+	}
+
+	// Fixture class for the K shortest paths
+	class KShortestPathsTest : public ::testing::Test
+	{
+	public:
+		// Costs of every simple path from v to dst, by depth first search
+		static void allPaths(const Graph& g, int v, int dst, int cost,
+			std::vector<bool>& onPath, std::vector<int>& costs)
+		{
+			if (v == dst)
+			{
+				costs.push_back(cost);
+				return;
+			}
+			onPath[v] = true;
+			IdRange ids = g.neighbors(Vertex(v));
+			IdRange edgeCosts = g.neighborCosts(Vertex(v));
+			for (int i = 0; i < ids.size(); ++i)
+			{
+				if (!onPath[ids[i]])
+				{
+					allPaths(g, ids[i], dst, cost + edgeCosts[i], onPath, costs);
+				}
+			}
+			onPath[v] = false;
+		}
+	};
+
+	// Test the routes match an exhaustive enumeration, with and without
+	// parallel spur searches
+	TEST_F(KShortestPathsTest, MatchesEnumeration)
+	{
+		Executor ex(3);
+		for (int round = 0; round < 10; ++round)
+		{
+			Graph g{ 8, 0.4 };
+			g.generate();
+			auto edges = [&g](int v, auto&& f)
+			{
+				IdRange ids = g.neighbors(Vertex(v));
+				IdRange costs = g.neighborCosts(Vertex(v));
+				for (int i = 0; i < ids.size(); ++i)
+				{
+					f(ids[i], costs[i]);
+				}
+			};
+			KShortestPaths serial(g.vertices(), edges);
+			KShortestPaths parallel(g.vertices(), edges, &ex);
+
+			std::vector<int> costs;
+			std::vector<bool> onPath(g.vertices(), false);
+			allPaths(g, 0, 7, 0, onPath, costs);
+			std::sort(costs.begin(), costs.end());
+			costs.resize(std::min<std::size_t>(costs.size(), 10));
+
+			for (KShortestPaths* k : { &serial, &parallel })
+			{
+				std::vector<Route> routes = k->find(0, 7, 10);
+				ASSERT_EQ(costs.size(), routes.size());
+				for (std::size_t i = 0; i < routes.size(); ++i)
+				{
+					EXPECT_EQ(costs[i], routes[i].cost);
+					EXPECT_EQ(0, routes[i].vertices.front());
+					EXPECT_EQ(7, routes[i].vertices.back());
+					int cost = 0;
+					for (std::size_t j = 1; j < routes[i].vertices.size(); ++j)
+					{
+						cost += g.edgeCost(routes[i].vertices[j - 1], routes[i].vertices[j]);
+					}
+					EXPECT_EQ(routes[i].cost, cost);
+				}
+			}
+		}
+	}
+
+	// Fixture class for the graph output
+	class GraphIoTest : public ::testing::Test
+	{
+	protected:
+		// 0 -> 1 (5), 1 -> 2 (12), 2 -> 0 (7)
+		static int cost(int i, int j)
+		{
+			static const int costs[3][3] = { { 0, 5, 0 }, { 0, 0, 12 }, { 7, 0, 0 } };
+			return costs[i][j];
+		}
+
+		static std::string dump(OutputFormat format)
+		{
+			std::ostringstream out;
+			writeGraph(out, 3, cost, format);
+			return out.str();
+		}
+
+		static std::string binary(std::initializer_list<std::int32_t> values)
+		{
+			std::string bytes("GRPH");
+			for (std::int32_t v : values)
+			{
+				bytes.append(reinterpret_cast<const char*>(&v), sizeof(v));
+			}
+			return bytes;
+		}
+	};
+
+	// Test each format byte for byte
+	TEST_F(GraphIoTest, Formats)
+	{
+		EXPECT_EQ("0 5 0 \n0 0 12 \n7 0 0 \n", dump(OutputFormat::Matrix));
+		EXPECT_EQ("3\n0 1 5\n1 2 12\n2 0 7\n", dump(OutputFormat::Sparse));
+		EXPECT_EQ(binary({ 3, 0, 1, 5, 1, 2, 12, 2, 0, 7 }), dump(OutputFormat::Binary));
+		EXPECT_EQ("", dump(OutputFormat::None));
+		EXPECT_EQ(OutputFormat::Matrix, parseOutputFormat("unknown"));
+	}
+
+	// Test a sparse dump reads back as the same edges
+	TEST_F(GraphIoTest, SparseReadsBack)
+	{
+		std::istringstream in(dump(OutputFormat::Sparse));
+		std::string line;
+		std::getline(in, line);
+		EXPECT_EQ("3", line);
+		int edges = 0;
+		while (std::getline(in, line))
+		{
+			WeightedEdge e;
+			ASSERT_TRUE(parseEdge(line, e)) << line;
+			EXPECT_EQ(cost(e.src, e.dst), e.cost);
+			++edges;
+		}
+		EXPECT_EQ(3, edges);
+	}
+
+	// Test writes around and beyond the buffer size keep their order
+	TEST_F(GraphIoTest, WriteLargerThanBuffer)
+	{
+		std::ostringstream out;
+		std::string big(40, 'x');
+		{
+			BufferedWriter w(out, 16);
+			w.put("ab").put(-123LL).put(' ');
+			// Goes straight to the stream after the buffered bytes
+			w.write(big.data(), big.size());
+			w.put('y');
+			// Exactly one buffer
+			w.write(big.data(), 16);
+			w.put(42LL);
+		}
+		EXPECT_EQ("ab-123 " + big + "y" + big.substr(0, 16) + "42", out.str());
+	}
+
+	// MatrixGraph with its cells set directly, as the programs' Graph
+	// classes do when they generate or read a graph
+	class EditableMatrixGraph : public MatrixGraph
+	{
+	public:
+		explicit EditableMatrixGraph(int size) : MatrixGraph(size)
+		{
+			m_matrix.resize(size, size);
+		}
+		// In matrix ids, so before any reorder() the external ids
+		void setEdge(int s, int d, int cost) { m_matrix[s][d] = cost; }
+		void setUndirected(int s, int d, int cost)
+		{
+			setEdge(s, d, cost);
+			setEdge(d, s, cost);
+		}
+	};
+
+	// Fixture class for the vertex reordering
+	class ReorderTest : public ::testing::Test
+	{
+	protected:
+		// Largest |i - j| over the edges, in matrix ids
+		static int bandwidth(const MatrixGraph& g)
+		{
+			int width = 0;
+			for (int v = 0; v < g.vertices(); ++v)
+			{
+				g.forEachNeighbor(v, [&width, v](int n, int)
+				{
+					width = std::max(width, std::abs(n - v));
+				});
+			}
+			return width;
+		}
+
+		// Random symmetric graph, costs 1..20
+		static EditableMatrixGraph randomGraph(int size, int edges, std::uint64_t seed)
+		{
+			EditableMatrixGraph g(size);
+			RandomStream rng(seed);
+			for (int e = 0; e < edges; ++e)
+			{
+				int s = rng.uniform(0, size - 1);
+				int d = rng.uniform(0, size - 1);
+				if (s != d)
+				{
+					g.setUndirected(s, d, rng.uniform(1, 20));
+				}
+			}
+			return g;
+		}
+	};
+
+	// Test only the documented names are accepted
+	TEST_F(ReorderTest, ParseOrdering)
+	{
+		Ordering order = Ordering::Degree;
+		EXPECT_TRUE(parseOrdering("cm", order));
+		EXPECT_EQ(Ordering::CuthillMcKee, order);
+		EXPECT_TRUE(parseOrdering("none", order));
+		EXPECT_EQ(Ordering::None, order);
+		EXPECT_TRUE(parseOrdering("degree", order));
+		EXPECT_EQ(Ordering::Degree, order);
+		for (const char* name : { "", "CM", "rcm", "degrees", " cm" })
+		{
+			EXPECT_FALSE(parseOrdering(name, order)) << name;
+			EXPECT_EQ(Ordering::Degree, order);
+		}
+	}
+
+	// Test the id maps are inverse bijections, also after a second reorder
+	TEST_F(ReorderTest, IdsRoundTrip)
+	{
+		EditableMatrixGraph g = randomGraph(50, 120, 7);
+		for (Ordering o : { Ordering::CuthillMcKee, Ordering::Degree })
+		{
+			g.reorder(o);
+			std::vector<bool> seen(g.vertices(), false);
+			for (int v = 0; v < g.vertices(); ++v)
+			{
+				int id = g.internalId(v);
+				ASSERT_GE(id, 0);
+				ASSERT_LT(id, g.vertices());
+				EXPECT_FALSE(seen[id]);
+				seen[id] = true;
+				EXPECT_EQ(v, g.externalId(id));
+			}
+		}
+	}
+
+	// Test a renumbered graph has the same distances for every pair and
+	// the same spanning tree cost, looked up through the id maps
+	TEST_F(ReorderTest, SameCostsAfterReorder)
+	{
+		EditableMatrixGraph original = randomGraph(60, 150, 11);
+		// A one way edge as well, so direction survives the renumbering
+		original.setEdge(3, 40, 2);
+		auto before = graph::Graph<int, true>::copyOf(original);
+		for (Ordering o : { Ordering::CuthillMcKee, Ordering::Degree })
+		{
+			EditableMatrixGraph g = original;
+			g.reorder(o);
+			auto after = graph::Graph<int, true>::copyOf(g);
+			for (int s = 0; s < g.vertices(); ++s)
+			{
+				auto expected = graph::shortestDistances(before, s);
+				auto actual = graph::shortestDistances(after, g.internalId(s));
+				for (int t = 0; t < g.vertices(); ++t)
+				{
+					EXPECT_EQ(expected[t], actual[g.internalId(t)]);
+				}
+			}
+		}
+		// The tree needs the undirected graph
+		original.setEdge(3, 40, 0);
+		EditableMatrixGraph g = original;
+		g.reorder(Ordering::CuthillMcKee);
+		EXPECT_EQ(graph::spanningTreeCost(graph::Graph<int, false>::copyOf(original)),
+			graph::spanningTreeCost(graph::Graph<int, false>::copyOf(g)));
+	}
+
+	// Test reverse Cuthill-McKee recovers a narrow band from shuffled ids
+	TEST_F(ReorderTest, CuthillMcKeeNarrowsBand)
+	{
+		const int size = 100;
+		std::vector<int> ids(size);
+		std::iota(ids.begin(), ids.end(), 0);
+		RandomStream rng(3);
+		for (int i = size - 1; i > 0; --i)
+		{
+			std::swap(ids[i], ids[rng.uniform(0, i)]);
+		}
+		// Band of width 2 under shuffled ids
+		EditableMatrixGraph g(size);
+		for (int v = 0; v < size; ++v)
+		{
+			for (int k = 1; k <= 2 && v + k < size; ++k)
+			{
+				g.setUndirected(ids[v], ids[v + k], 1);
+			}
+		}
+		int shuffled = bandwidth(g);
+		g.reorder(Ordering::CuthillMcKee);
+		EXPECT_GT(shuffled, 20);
+		EXPECT_LE(bandwidth(g), 4);
+	}
+
+	// Fixture class for the external memory Kruskal
+	class KruskalTest : public ::testing::Test
+	{
+	protected:
+		std::string m_file;
+
+		void SetUp() override
+		{
+			m_file = ::testing::TempDir() + "kruskal_test.txt";
+		}
+		void TearDown() override
+		{
+			std::remove(m_file.c_str());
+		}
+
+		// Data file in the mst format: the size, then "i j c" lines
+		void write(int size, const std::vector<WeightedEdge>& edges)
+		{
+			std::ofstream out(m_file);
+			out << size << '\n';
+			for (auto& e : edges)
+			{
+				out << e.src << ' ' << e.dst << ' ' << e.cost << '\n';
+			}
+		}
+
+		// Prim over the same edges, as (cost, tree edges)
+		static std::pair<int, std::size_t> prim(int size, const std::vector<WeightedEdge>& edges)
+		{
+			graph::Graph<int, false, graph::Csr> g(size);
+			for (auto& e : edges)
+			{
+				g.addEdge(e.src, e.dst, e.cost);
+			}
+			graph::MST<decltype(g)> mst(g);
+			mst.prim();
+			std::size_t tree = 0;
+			for (int v = 0; v < size; ++v)
+			{
+				tree += mst.parent(v) >= 0;
+			}
+			return std::make_pair(mst.cost(), tree);
+		}
+
+		// Random simple graph: no self loops or repeated pairs
+		static std::vector<WeightedEdge> randomEdges(int size, int count, std::uint64_t seed)
+		{
+			RandomStream rng(seed);
+			std::vector<bool> used(static_cast<std::size_t>(size) * size, false);
+			std::vector<WeightedEdge> edges;
+			while (static_cast<int>(edges.size()) < count)
+			{
+				int s = rng.uniform(0, size - 1);
+				int d = rng.uniform(0, size - 1);
+				if (s == d || used[s * size + d])
+				{
+					continue;
+				}
+				used[s * size + d] = used[d * size + s] = true;
+				edges.push_back(WeightedEdge{ s, d, rng.uniform(1, 100) });
+			}
+			return edges;
+		}
+	};
+
+	// Test small chunks spill many runs, collapse them past the run limit,
+	// and still give Prim's tree cost
+	TEST_F(KruskalTest, SpilledRunsMatchPrim)
+	{
+		std::vector<WeightedEdge> edges = randomEdges(200, 2400, 3);
+		write(200, edges);
+		std::pair<int, std::size_t> expected = prim(200, edges);
+		// 16 edge chunks give 150 runs, over the limit of 64 twice
+		for (std::size_t chunk : { std::size_t(16), std::size_t(1000), std::size_t(1 << 20) })
+		{
+			ExternalMST mst(chunk, ::testing::TempDir());
+			ASSERT_TRUE(mst.compute(m_file)) << mst.error();
+			EXPECT_EQ(expected.first, mst.cost());
+			EXPECT_EQ(expected.second, mst.tree().size());
+		}
+	}
+
+	// Test a disconnected graph gives a spanning forest
+	TEST_F(KruskalTest, DisconnectedForest)
+	{
+		std::vector<WeightedEdge> edges = {
+			{ 0, 1, 4 }, { 1, 2, 1 }, { 0, 2, 3 },
+			{ 3, 4, 7 }, { 4, 5, 2 }, { 3, 5, 9 }, { 2, 2, 1 }
+		};
+		write(7, edges);
+		ExternalMST mst(2, ::testing::TempDir());
+		ASSERT_TRUE(mst.compute(m_file)) << mst.error();
+		EXPECT_EQ(13, mst.cost());
+		EXPECT_EQ(4u, mst.tree().size());
+		EXPECT_EQ(prim(7, edges).first, mst.cost());
+	}
+
+	// Test an input error and an unwritable run directory are reported
+	TEST_F(KruskalTest, ReportsErrors)
+	{
+		write(3, { { 0, 1, 1 }, { 1, 3, 1 } });
+		ExternalMST bad;
+		EXPECT_FALSE(bad.compute(m_file));
+		EXPECT_NE(std::string::npos, bad.error().find("out of range on line 3"));
+
+		write(50, randomEdges(50, 100, 5));
+		ExternalMST spill(10, ::testing::TempDir() + "no_such_dir/nested");
+		EXPECT_FALSE(spill.compute(m_file));
+		EXPECT_NE(std::string::npos, spill.error().find("Unable to write run file"));
+
+		ExternalMST missing;
+		EXPECT_FALSE(missing.compute(m_file + ".missing"));
+		EXPECT_NE(std::string::npos, missing.error().find("Unable to read"));
+	}
+
+	// Test edge lines are parsed strictly
+	TEST_F(KruskalTest, ParseEdge)
+	{
+		WeightedEdge e{};
+		ASSERT_TRUE(parseEdge(" 1\t2 -3", e));
+		EXPECT_EQ(1, e.src);
+		EXPECT_EQ(2, e.dst);
+		EXPECT_EQ(-3, e.cost);
+		ASSERT_TRUE(parseEdge("2147483647 0 1", e));
+		EXPECT_EQ(INT_MAX, e.src);
+		for (const char* line : { "", "1 2", "a b c", "1 2 x", "1 - 2", "99999999999 1 2", "2147483648 0 1" })
+		{
+			EXPECT_FALSE(parseEdge(line, e)) << line;
+		}
+	}
+
+	// Fixture class for the reductions
+	class ReduceTest : public ::testing::Test
+	{
+	};
+
+	// Test the eight accumulator sum on lengths below, at and past the
+	// lane width, where the tail loop does the work
+	TEST(ReduceTest, IntegerSumOddLengths)
+	{
+		for (std::size_t n : { 0, 1, 3, 7, 8, 9, 15, 17, 33 })
+		{
+			std::vector<int> v(n);
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				v[i] = static_cast<int>(i) * 3 - 5;
+			}
+			EXPECT_EQ(std::accumulate(v.begin(), v.end(), 0), reduce::sum(reduce::span(v))) << n;
+			EXPECT_EQ(std::accumulate(v.begin(), v.end(), 0), reduce::pairwiseSum(reduce::span(v))) << n;
+		}
+	}
+
+	// Test compensated and pairwise sums lose less than a naive running
+	// sum on ill-conditioned input
+	TEST(ReduceTest, AccurateSumsBeatNaive)
+	{
+		// Every 1 is lost next to 1e16 in a running sum
+		std::vector<double> cancel(1, 1e16);
+		cancel.insert(cancel.end(), 10000, 1.0);
+		cancel.push_back(-1e16);
+		EXPECT_NE(10000.0, std::accumulate(cancel.begin(), cancel.end(), 0.0));
+		EXPECT_EQ(10000.0, reduce::kahanSum(reduce::span(cancel)));
+
+		// A million float tenths: the running sum drifts with n
+		std::vector<float> tenths(1000000, 0.1f);
+		double exact = 1000000 * static_cast<double>(0.1f);
+		float naive = 0;
+		for (float x : tenths)
+		{
+			naive += x;
+		}
+		double naiveError = std::abs(naive - exact);
+		EXPECT_LT(std::abs(reduce::pairwiseSum(reduce::span(tenths)) - exact), naiveError / 100);
+		EXPECT_LT(std::abs(reduce::kahanSum(reduce::span(tenths)) - exact), naiveError / 100);
+	}
+
+	// Test the parallel sum matches the serial one on sizes around the
+	// chunk boundaries, with the caller summing the last chunk
+	TEST(ReduceTest, ParallelMatchesSum)
+	{
+		std::vector<int> v(1000);
+		for (std::size_t i = 0; i < v.size(); ++i)
+		{
+			v[i] = static_cast<int>(i % 97) - 40;
+		}
+		for (std::size_t n : { 0, 63, 64, 127, 128, 129, 255, 256, 257, 1000 })
+		{
+			reduce::Span<int> s(v.data(), n);
+			EXPECT_EQ(reduce::sum(s), reduce::parallelSum(s, reduce::Summation::Fast, 4, 64)) << n;
+			EXPECT_EQ(reduce::sum(s), reduce::parallelSum(s, reduce::Summation::Pairwise, 3, 64)) << n;
+		}
+	}
+
+	// Test subtract starts from the given value
+	TEST(ReduceTest, SubtractFromStart)
+	{
+		std::vector<int> v = { 1, 2, 3 };
+		EXPECT_EQ(4, reduce::subtract(reduce::span(v), 10));
+		EXPECT_EQ(-6, reduce::subtract(reduce::span(v)));
+		EXPECT_DOUBLE_EQ(0.5, reduce::subtract(reduce::span(std::vector<double>{ 0.25, 0.25 }), 1.0));
+	}
+
+	// Test the marker value is left out and the sum is widened
+	TEST(ReduceTest, SumExcluding)
+	{
+		std::vector<int> v = { 4, INT_MAX, 1, INT_MAX - 1, INT_MAX - 1, 7, INT_MAX, 3, 2, 1 };
+		long long expected = 4 + 1 + 7 + 3 + 2 + 1 + 2LL * (INT_MAX - 1);
+		EXPECT_EQ(expected, reduce::sumExcluding<long long>(reduce::span(v), INT_MAX));
+		EXPECT_EQ(0, reduce::sumExcluding<long long>(reduce::Span<int>(v.data(), 0), INT_MAX));
+	}
+
+	// Fixture class for the Matrix container
+	class MatrixTest : public ::testing::Test
+	{
+	};
+
+	// Test the rows are aligned, padded with zeros and survive a resize
+	TEST(MatrixTest, AlignedRows)
+	{
+		Matrix<int> m(5, 19);
+		EXPECT_EQ(32u, m.stride());
+		for (std::size_t i = 0; i < m.rows(); ++i)
+		{
+			EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(m[i]) % Matrix<int>::alignment);
+			for (std::size_t j = 0; j < m.cols(); ++j)
+			{
+				m[i][j] = static_cast<int>(i * 100 + j);
+			}
+		}
+		m.fill(1);
+		EXPECT_EQ(19, reduce::sum(m.row(4)));
+		EXPECT_EQ(0, m[4][19]);
+		m[2][3] = 7;
+		m.resize(3, 40);
+		EXPECT_EQ(7, m[2][3]);
+		EXPECT_EQ(0, m[2][30]);
+		Matrix<int> copy = m;
+		copy[2][3] = 8;
+		EXPECT_EQ(7, m[2][3]);
+	}
+
+	// Test the tiled transpose on a shape which is not a multiple of a tile,
+	// with and without huge page backing
+	TEST(MatrixTest, Transpose)
+	{
+		for (MatrixMemory memory : { MatrixMemory::Default, MatrixMemory::HugePages })
+		{
+			Matrix<int> m(37, 70, memory);
+			for (std::size_t i = 0; i < m.rows(); ++i)
+			{
+				for (std::size_t j = 0; j < m.cols(); ++j)
+				{
+					m[i][j] = static_cast<int>(i * 1000 + j);
+				}
+			}
+			Matrix<int> t = m.transpose();
+			ASSERT_EQ(70u, t.rows());
+			ASSERT_EQ(37u, t.cols());
+			for (std::size_t i = 0; i < m.rows(); ++i)
+			{
+				for (std::size_t j = 0; j < m.cols(); ++j)
+				{
+					EXPECT_EQ(m[i][j], t[j][i]);
+				}
+			}
+		}
+	}
+
+	// Fixture class for the graph-core kernels
+	class KernelsTest : public ::testing::Test
+	{
+	};
+
+	// Test every kernel level this CPU supports against the scalar one, on
+	// lengths which are not multiples of the vector widths and with ties
+	TEST(KernelsTest, LevelsAgree)
+	{
+		Random r;
+		const core::Isa levels[] = { core::Isa::Scalar, core::Isa::Sse2, core::Isa::Avx2, core::Isa::Avx512 };
+		for (int n = 0; n < 70; ++n)
+		{
+			std::vector<int> values(n);
+			std::vector<unsigned char> visited(n);
+			std::vector<int> row(n);
+			for (int i = 0; i < n; ++i)
+			{
+				values[i] = r.getRandom(0, 4) == 0 ? INT_MAX : r.getRandom(1, 5);
+				visited[i] = r.getRandom(0, 2) == 0;
+				row[i] = r.getRandom(0, 2) == 0 ? r.getRandom(1, 9) : 0;
+			}
+			core::selectIsa(core::Isa::Scalar);
+			int minimum = core::minimumUnvisited(values.data(), visited.data(), n);
+			std::vector<int> expected(n + 1);
+			expected.resize(core::nonZeroIndices(row.data(), n, expected.data()));
+
+			for (core::Isa isa : levels)
+			{
+				if (core::selectIsa(isa) != isa)
+				{
+					continue;
+				}
+				EXPECT_EQ(minimum, core::minimumUnvisited(values.data(), visited.data(), n)) << core::isaName(isa);
+				std::vector<int> indices(n + 1);
+				indices.resize(core::nonZeroIndices(row.data(), n, indices.data()));
+				EXPECT_EQ(expected, indices) << core::isaName(isa);
+			}
+		}
+		core::selectIsa(core::detectIsa());
+	}
+
+	TEST(KernelsTest, RandomBlocksAgree)
+	{
+		const core::Isa levels[] = { core::Isa::Scalar, core::Isa::Sse2, core::Isa::Avx2, core::Isa::Avx512 };
+		std::uint64_t seed[32];
+		for (int i = 0; i < 32; ++i)
+		{
+			seed[i] = 0x9E3779B97F4A7C15ull * (i + 1);
+		}
+		core::selectIsa(core::Isa::Scalar);
+		std::uint64_t state[32];
+		std::copy(seed, seed + 32, state);
+		std::vector<std::uint64_t> expected(8 * 37);
+		core::randomBlocks(state, expected.data(), 37);
+
+		for (core::Isa isa : levels)
+		{
+			if (core::selectIsa(isa) != isa)
+			{
+				continue;
+			}
+			std::copy(seed, seed + 32, state);
+			std::vector<std::uint64_t> out(8 * 37);
+			core::randomBlocks(state, out.data(), 37);
+			EXPECT_EQ(expected, out) << core::isaName(isa);
+		}
+		core::selectIsa(core::detectIsa());
+	}
+
+	// Fixture class for the tracing
+	class TraceTest : public ::testing::Test
+	{
+	};
+
+	// Scopes are recorded only while enabled, per thread, and exported
+	TEST(TraceTest, RecordsScopes)
+	{
+		trace::enable(true);
+		trace::clear();
+		{
+			TRACE_SCOPE("test outer");
+			TRACE_SCOPE("test inner");
+		}
+		{
+			Executor ex(1);
+			ex.submit([] { TRACE_SCOPE("test worker"); }).get();
+		}
+		trace::enable(false);
+		{
+			TRACE_SCOPE("test disabled");
+		}
+
+		std::ostringstream json;
+		trace::writeChromeTrace(json);
+		// Thread ids keep counting across runs, so only compare them
+		auto tid = [&json](const std::string& name)
+		{
+			std::string event = "\"name\":\"" + name + "\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+			std::size_t at = json.str().find(event);
+			return at == std::string::npos ? -1 : std::atoi(json.str().c_str() + at + event.size());
+		};
+		EXPECT_GT(tid("test outer"), 0);
+		EXPECT_EQ(tid("test outer"), tid("test inner"));
+		EXPECT_GT(tid("test worker"), 0);
+		EXPECT_NE(tid("test outer"), tid("test worker"));
+		EXPECT_EQ(std::string::npos, json.str().find("test disabled"));
+
+		std::ostringstream histograms;
+		trace::writeHistograms(histograms);
+		EXPECT_NE(std::string::npos, histograms.str().find("test inner: 1 calls"));
+		trace::clear();
+	}
+
+	// Fixture class for the load generator
+	class LoadgenTest : public ::testing::Test
+	{
+	};
+
+	// Percentiles are exact to the histogram's 1/128 precision
+	TEST(LoadgenTest, HistogramPercentiles)
+	{
+		LatencyHistogram a, b;
+		for (std::uint64_t v = 1; v <= 100000; ++v)
+		{
+			(v % 2 ? a : b).record(v * 1000);
+		}
+		a.merge(b);
+		EXPECT_EQ(100000u, a.count());
+		EXPECT_EQ(1000u, a.min());
+		EXPECT_EQ(100000000u, a.max());
+		EXPECT_NEAR(50000000.0, static_cast<double>(a.percentile(50)), 50000000.0 / 128);
+		EXPECT_NEAR(99000000.0, static_cast<double>(a.percentile(99)), 99000000.0 / 128);
+		EXPECT_NEAR(99900000.0, static_cast<double>(a.percentile(99.9)), 99900000.0 / 128);
+		EXPECT_EQ(a.max(), a.percentile(100));
+		EXPECT_NEAR(50000500.0, a.mean(), 1.0);
+	}
+
+	// Generated queries are in range, reproducible, and shaped as asked
+	TEST(LoadgenTest, Workloads)
+	{
+		Graph g{ 300, 0.02 };
+		g.generate();
+		for (Workload w : { Workload::Uniform, Workload::Zipf, Workload::Local })
+		{
+			RandomStream r1(5), r2(5);
+			std::vector<Query> q1 = makeQueries(g, w, 2000, r1, 1.2, 2);
+			std::vector<Query> q2 = makeQueries(g, w, 2000, r2, 1.2, 2);
+			ASSERT_EQ(2000u, q1.size());
+			for (std::size_t i = 0; i < q1.size(); ++i)
+			{
+				ASSERT_TRUE(q1[i].src >= 0 && q1[i].src < 300 && q1[i].dst >= 0 && q1[i].dst < 300);
+				EXPECT_TRUE(q1[i].src == q2[i].src && q1[i].dst == q2[i].dst);
+			}
+			if (w == Workload::Zipf)
+			{
+				// The hottest vertex gets a large share of the queries
+				std::vector<int> hits(300, 0);
+				for (auto& q : q1)
+				{
+					++hits[q.src];
+				}
+				EXPECT_GT(*std::max_element(hits.begin(), hits.end()), 200);
+			}
+			if (w == Workload::Local)
+			{
+				// dst is at most 2 edges from src
+				ShortestPath sp{ Graph(g) };
+				for (std::size_t i = 0; i < 50; ++i)
+				{
+					EXPECT_TRUE(sp.path(q1[i].src, q1[i].dst));
+				}
+			}
+		}
+
+		std::stringstream io;
+		std::vector<Query> queries = { { 1, 2 }, { 3, 4 } };
+		writeQueries(io, queries);
+		std::vector<Query> read = readQueries(io);
+		ASSERT_EQ(2u, read.size());
+		EXPECT_EQ(3, read[1].src);
+		EXPECT_EQ(4, read[1].dst);
+	}
+
+	// Fixture class for the memory accounting
+	class FootprintTest : public ::testing::Test
+	{
+	};
+
+	// Live, peak and overhead bytes follow the allocations
+	TEST(FootprintTest, TracksComponents)
+	{
+		footprint::Usage before = footprint::usage(footprint::Component::Other);
+		{
+			// 3 ints per row padded to a 64 byte line
+			Matrix<int> m(10, 3, MatrixMemory::Default, footprint::Component::Other);
+			footprint::Usage u = footprint::usage(footprint::Component::Other);
+			EXPECT_EQ(before.live + 640, u.live);
+			EXPECT_EQ(before.overhead + 10 * 13 * sizeof(int), u.overhead);
+			EXPECT_EQ(before.allocations + 1, u.allocations);
+			EXPECT_LE(before.live + 640, u.peak);
+
+			footprint::Vector<double, footprint::Component::Other> v(100);
+			EXPECT_EQ(before.live + 640 + 800, footprint::usage(footprint::Component::Other).live);
+		}
+		footprint::Usage after = footprint::usage(footprint::Component::Other);
+		EXPECT_EQ(before.live, after.live);
+		EXPECT_EQ(before.overhead, after.overhead);
+		EXPECT_LE(before.live + 1440, after.peak);
+	}
+
+	// Graph copies are counted, moves and shared graphs are not
+	TEST(FootprintTest, CountsGraphCopies)
+	{
+		Graph g{ 20, 0.3 };
+		g.generate();
+		EXPECT_EQ(g.memoryBytes(), (21 + 2 * static_cast<std::size_t>(g.edges())) * sizeof(int));
+		std::size_t copies = footprint::graphCopies();
+		Graph copy = g;
+		EXPECT_EQ(copies + 1, footprint::graphCopies());
+		Graph moved = std::move(copy);
+		auto shared = std::make_shared<const Graph>(std::move(moved));
+		ShortestPath a(shared), b(shared);
+		EXPECT_EQ(copies + 1, footprint::graphCopies());
+		EXPECT_GE(a.memoryBytes(), 20 * sizeof(int));
+	}
+
+	// Fixture class for the NUMA placement
+	class NumaTest : public ::testing::Test
+	{
+	};
+
+	// Test the placements give the same zeroed matrix and replicas of it
+	TEST(NumaTest, PlacementsAgree)
+	{
+		ASSERT_GE(numa::nodes(), 1);
+		EXPECT_TRUE(numa::pinThread(numa::nodes() - 1));
+		EXPECT_EQ(numa::nodes() - 1, numa::currentNode());
+		numa::unpinThread();
+		EXPECT_FALSE(numa::pinThread(numa::nodes()));
+
+		std::vector<unsigned char> block(3 * 4096 + 100, 0xff);
+		numa::interleave(block.data() + 7, block.size() - 7, 4096);
+		EXPECT_EQ(0xff, block[6]);
+		EXPECT_EQ(block.size() - 7, static_cast<std::size_t>(std::count(block.begin(), block.end(), 0)));
+
+		Matrix<int> m(300, 300, MatrixMemory::HugePages | MatrixMemory::Interleaved);
+		EXPECT_EQ(0, reduce::sum(m.row(299)));
+		m[7][11] = 5;
+		numa::Replicated<Matrix<int>> copies(m);
+		EXPECT_EQ(numa::nodes(), copies.copies());
+		EXPECT_EQ(5, copies.local()[7][11]);
+		EXPECT_NE(m.data(), copies.on(0).data());
+
+		// A single pinned worker is on node 0
+		Executor ex(1, true);
+		EXPECT_EQ(0, ex.submit([] { return numa::currentNode(); }).get());
+	}
+
+	// Fixture class for the sharded solver
+	class ShardTest : public ::testing::Test
+	{
+	};
+
+	// Test every vertex has exactly one owner, in id order
+	TEST(ShardTest, MapCoversVertices)
+	{
+		ShardMap map(10, 3);
+		EXPECT_EQ(0, map.first(0));
+		EXPECT_EQ(10, map.first(3));
+		for (int v = 0; v < 10; ++v)
+		{
+			int k = map.owner(v);
+			EXPECT_LE(map.first(k), v);
+			EXPECT_LT(v, map.first(k + 1));
+		}
+		EXPECT_EQ(2, ShardMap(2, 5).shards());
+	}
+
+	// Test the supersteps, routed in process, give the distances of
+	// ShortestPath for any shard count
+	TEST(ShardTest, SuperstepsMatchShortestPath)
+	{
+		Graph g{ 150, 0.03 };
+		g.generate();
+		std::vector<Edge> edges;
+		for (int v = 0; v < g.vertices(); ++v)
+		{
+			IdRange ids = g.neighbors(Vertex(v));
+			IdRange costs = g.neighborCosts(Vertex(v));
+			for (int i = 0; i < ids.size(); ++i)
+			{
+				edges.push_back(Edge(v, ids[i], costs[i]));
+			}
+		}
+		ShortestPath sp(std::move(g));
+
+		for (int shards : { 1, 3, 7 })
+		{
+			ShardMap map(sp.vertices(), shards);
+			std::vector<Shard> parts;
+			for (int k = 0; k < map.shards(); ++k)
+			{
+				parts.emplace_back(map, k);
+				parts.back().build(edges);
+			}
+			std::vector<ShardWorker> workers;
+			for (auto& s : parts)
+			{
+				workers.emplace_back(s);
+				workers.back().start(5);
+			}
+			std::vector<std::vector<Update>> outbox(map.shards());
+			SearchStats stats = coordinate(map,
+				[&](int k, const std::vector<Update>& inbox) { outbox[k] = workers[k].step(inbox); },
+				[&](int k) { return outbox[k]; });
+			EXPECT_GE(stats.supersteps, 1);
+			if (shards == 1)
+			{
+				EXPECT_EQ(1, stats.supersteps);
+			}
+
+			for (int v = 0; v < sp.vertices(); ++v)
+			{
+				int expected = sp.path(Vertex(5), Vertex(v)) ? sp.pathCost() : INT_MAX;
+				EXPECT_EQ(expected, workers[map.owner(v)].distance(v));
+			}
+		}
+	}
+	// Each generator gives the expected sizes and degree shape, and its
+	// edges build a valid graph
+	TEST(GeneratorTest, Shapes)
+	{
+		RandomStream rng(7);
+		std::vector<Edge> edges;
+		auto collect = [&](int s, int d, int c) { edges.push_back(Edge(s, d, c)); };
+
+		generators::grid(10, 20, rng, collect, 1.0);
+		// Every horizontal and vertical road both ways
+		EXPECT_EQ(2u * (10 * 19 + 9 * 20), edges.size());
+		Graph grid(200, 0.0);
+		grid.build(edges);
+		EXPECT_EQ(static_cast<int>(edges.size()), grid.edges());
+		for (int v = 0; v < grid.vertices(); ++v)
+		{
+			EXPECT_LE(grid.degree(v), 4);
+			EXPECT_GE(grid.degree(v), 2);
+		}
+
+		edges.clear();
+		generators::geometric(4000, 8.0, rng, collect);
+		double mean = static_cast<double>(edges.size()) / 4000;
+		// Border points have fewer neighbours than the interior ones
+		EXPECT_GT(mean, 6.0);
+		EXPECT_LT(mean, 9.0);
+		Graph geo(4000, 0.0);
+		geo.build(edges);
+		EXPECT_EQ(static_cast<int>(edges.size()), geo.edges());
+
+		edges.clear();
+		generators::rmat(12, 8, rng, collect);
+		EXPECT_EQ(8u << 12, edges.size());
+		Graph rmat(1 << 12, 0.0);
+		rmat.build(edges);
+		int maxDegree = 0;
+		for (int v = 0; v < rmat.vertices(); ++v)
+		{
+			maxDegree = std::max(maxDegree, rmat.degree(v));
+		}
+		// Skewed: the hubs are far above the mean of 8
+		EXPECT_GT(maxDegree, 80);
+
+		edges.clear();
+		generators::barabasiAlbert(2000, 3, rng, collect);
+		// The clique of 4 then 3 two way edges per vertex
+		EXPECT_EQ(2u * (6 + 3 * 1996), edges.size());
+		Graph ba(2000, 0.0);
+		ba.build(edges);
+		EXPECT_EQ(static_cast<int>(edges.size()), ba.edges());
+		for (int v = 0; v < ba.vertices(); ++v)
+		{
+			EXPECT_GE(ba.degree(v), 3);
+		}
+	}
+
+	// EdgeWriter output is the sparse file format
+	TEST(GeneratorTest, EdgeWriterSparse)
+	{
+		std::ostringstream out;
+		{
+			EdgeWriter w(out, 6, OutputFormat::Sparse);
+			RandomStream rng(3);
+			generators::grid(2, 3, rng, [&w](int s, int d, int c) { w(s, d, c); }, 1.0);
+			EXPECT_EQ(14, w.edges());
+		}
+		std::istringstream in(out.str());
+		int size = 0;
+		in >> size;
+		EXPECT_EQ(6, size);
+		int s, d, c, lines = 0;
+		while (in >> s >> d >> c)
+		{
+			EXPECT_GE(c, 1);
+			EXPECT_LE(c, 10);
+			++lines;
+		}
+		EXPECT_EQ(14, lines);
+	}
+	// A saved tree maps back in a new store with the solver's distances
+	// and routes; a changed graph or a damaged file is not matched.
+	TEST(TreeStoreTest, SaveAndMapBack)
+	{
+		Graph g(60, 0.1);
+		g.generate();
+		auto shared = std::make_shared<const Graph>(g);
+		ShortestPath sp(shared);
+		std::string dir = ::testing::TempDir();
+		if (!dir.empty() && (dir.back() == '/' || dir.back() == '\\'))
+		{
+			dir.pop_back();
+		}
+		{
+			TreeStore store(dir, g);
+			std::remove(store.fileName(3).c_str());
+			EXPECT_FALSE(store.find(3));
+			ASSERT_TRUE(store.save(sp, 3));
+		}
+
+		TreeStore store(dir, g);
+		std::shared_ptr<const StoredTree> tree = store.find(3);
+		ASSERT_TRUE(tree);
+		EXPECT_EQ(3, tree->source());
+		EXPECT_EQ(g.vertices(), tree->vertices());
+		for (int v = 0; v < g.vertices(); ++v)
+		{
+			bool found = sp.path(Vertex(3), Vertex(v));
+			EXPECT_EQ(found ? sp.pathCost() : INT_MAX, tree->distance(v));
+			std::vector<int> route = tree->route(v);
+			if (found)
+			{
+				ASSERT_FALSE(route.empty());
+				EXPECT_EQ(3, route.front());
+				EXPECT_EQ(v, route.back());
+				int cost = 0;
+				for (std::size_t i = 1; i < route.size(); ++i)
+				{
+					cost += g.edgeCost(route[i - 1], route[i]);
+				}
+				EXPECT_EQ(sp.pathCost(), cost);
+			}
+			else
+			{
+				EXPECT_TRUE(route.empty());
+			}
+		}
+		EXPECT_FALSE(store.find(4));
+
+		// Another graph has another checksum, so the tree is not found
+		Graph other(g.vertices(), 0.1);
+		other.generate();
+		EXPECT_NE(g.checksum(), other.checksum());
+		EXPECT_FALSE(TreeStore(dir, other).find(3));
+
+		// A truncated file is ignored
+		std::string name = store.fileName(3);
+		{
+			std::ofstream out(name, std::ios::binary | std::ios::trunc);
+			out << "SPTR";
+		}
+		EXPECT_FALSE(TreeStore(dir, g).find(3));
+		std::remove(name.c_str());
+	}
+	// The true cost is always within the oracle's bounds, exact from a
+	// landmark, and a serialised oracle answers the same
+	TEST(OracleTest, BoundsHoldAndRoundTrip)
+	{
+		auto g = std::make_shared<Graph>(120, 0.04);
+		g->generate();
+		ShortestPath sp(g);
+		Executor ex(2);
+		for (Landmarks selection : { Landmarks::Random, Landmarks::Farthest })
+		{
+			DistanceOracle oracle(g, 8, ex, selection, 5);
+			EXPECT_EQ(8, oracle.landmarks());
+			for (int s = 0; s < g->vertices(); s += 7)
+			{
+				for (int t = 0; t < g->vertices(); t += 3)
+				{
+					int cost = sp.path(Vertex(s), Vertex(t)) ? sp.pathCost() : INT_MAX;
+					Estimate e = oracle.estimate(s, t);
+					EXPECT_LE(e.lower, cost);
+					EXPECT_GE(e.upper, cost);
+					// Neither flag may contradict the true cost
+					EXPECT_TRUE(cost == INT_MAX || e.reachable);
+					EXPECT_TRUE(cost != INT_MAX || !e.bounded);
+				}
+			}
+			int l = oracle.landmark(0);
+			for (int t = 0; t < g->vertices(); ++t)
+			{
+				int cost = sp.path(Vertex(l), Vertex(t)) ? sp.pathCost() : INT_MAX;
+				Estimate e = oracle.estimate(l, t);
+				EXPECT_EQ(cost, e.upper);
+				EXPECT_EQ(cost != INT_MAX, e.bounded);
+				EXPECT_EQ(cost != INT_MAX, e.reachable);
+			}
+		}
+
+		DistanceOracle oracle(g, 4, ex);
+		std::stringstream buffer;
+		oracle.write(buffer);
+		std::unique_ptr<DistanceOracle> copy = DistanceOracle::read(buffer);
+		ASSERT_TRUE(copy);
+		EXPECT_EQ(g->checksum(), copy->checksum());
+		EXPECT_EQ(oracle.landmarks(), copy->landmarks());
+		for (int s = 0; s < g->vertices(); s += 11)
+		{
+			for (int t = 0; t < g->vertices(); t += 5)
+			{
+				EXPECT_EQ(oracle.estimate(s, t).lower, copy->estimate(s, t).lower);
+				EXPECT_EQ(oracle.estimate(s, t).upper, copy->estimate(s, t).upper);
+				EXPECT_EQ(oracle.estimate(s, t).bounded, copy->estimate(s, t).bounded);
+			}
+		}
+		std::stringstream truncated(buffer.str().substr(0, 30));
+		EXPECT_FALSE(DistanceOracle::read(truncated));
+	}
+	// A batch of changes gives the same graph as building from scratch
+	TEST(SnapshotTest, WithChangesMatchesBuild)
+	{
+		Graph g(80, 0.1);
+		g.generate();
+		std::vector<Edge> edges;
+		for (int v = 0; v < g.vertices(); ++v)
+		{
+			IdRange ids = g.neighbors(Vertex(v));
+			IdRange costs = g.neighborCosts(Vertex(v));
+			for (int i = 0; i < ids.size(); ++i)
+			{
+				edges.push_back(Edge(v, ids[i], costs[i]));
+			}
+		}
+		RandomStream rng(9);
+		std::vector<Edge> changes;
+		for (int c = 0; c < 300; ++c)
+		{
+			changes.push_back(Edge(rng.uniform(0, 79), rng.uniform(0, 79), rng.uniform(0, 10)));
+		}
+		Graph changed = g.withChanges(changes);
+
+		// The same changes applied one by one to the edge list
+		for (const Edge& c : changes)
+		{
+			edges.erase(std::remove(edges.begin(), edges.end(), c), edges.end());
+			if (c.getCost())
+			{
+				edges.push_back(c);
+			}
+		}
+		Graph expected(80, 0.1);
+		expected.build(edges);
+		EXPECT_EQ(expected.edges(), changed.edges());
+		EXPECT_EQ(expected.checksum(), changed.checksum());
+	}
+
+	// Readers running while a writer publishes never see a mix of two
+	// versions, and every replaced snapshot is reclaimed
+	TEST(SnapshotTest, ReadersSeeWholeSnapshots)
+	{
+		// A chain 0 -> 1 -> ... -> 49, every edge of version n costing n + 1
+		const int size = 50;
+		std::vector<Edge> chain;
+		for (int v = 0; v + 1 < size; ++v)
+		{
+			chain.push_back(Edge(v, v + 1, 1));
+		}
+		Graph g(size, 0.02);
+		g.build(chain);
+		VersionedGraph vg(std::move(g), 8);
+
+		std::atomic<bool> done(false);
+		std::atomic<int> torn(0);
+		std::vector<std::thread> readers;
+		for (int r = 0; r < 4; ++r)
+		{
+			readers.emplace_back([&]()
+			{
+				ShortestPath sp(vg.pin().shared());
+				while (!done)
+				{
+					VersionedGraph::Snapshot s = vg.pin();
+					int cost = static_cast<int>(s.version()) + 1;
+					sp.rebind(s.shared());
+					if (!sp.path(Vertex(0), Vertex(size - 1)) || sp.pathCost() != (size - 1) * cost)
+					{
+						++torn;
+					}
+				}
+			});
+		}
+		for (int n = 1; n <= 200; ++n)
+		{
+			std::vector<Edge> changes;
+			for (const Edge& e : chain)
+			{
+				changes.push_back(Edge(e.getSrc(), e.getDst(), n + 1));
+			}
+			vg.update(changes);
+		}
+		done = true;
+		for (auto& t : readers)
+		{
+			t.join();
+		}
+		EXPECT_EQ(0, torn.load());
+		EXPECT_EQ(0u, vg.retired());
+		EXPECT_EQ(200u, vg.pin().version());
+		EXPECT_EQ(201, vg.pin()->edgeCost(0, 1));
+	}
 } // namespace
 
 int main(int argc, char **argv)
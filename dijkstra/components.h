@@ -0,0 +1,179 @@
+/*
+Connected component labels for constant time reachability rejection.
+
+Computed once per graph, in O(V + E):
+	weak   - components of the graph with edge direction ignored
+	strong - strongly connected components (Tarjan)
+
+Tarjan finishes a component only after every component reachable from
+it, so the component ids are a reverse topological order of the
+condensation: an edge u -> v between two components always has
+strong(u) > strong(v).  Hence dst can only be reachable from src if
+both are in the same weak component and strong(src) >= strong(dst), and
+it is always reachable if both are in the same strong component.
+
+Works from any graph given as forEachNeighbor(v, f), calling f(n) for
+every edge v -> n; components(m, size) adapts an m[i][j] matrix.
+*/
+#pragma once
+#include <vector>
+
+// Components ADT
+class Components
+{
+private:
+	std::vector<int> m_weak;
+	std::vector<int> m_strong;
+	int m_weakCount;
+	int m_strongCount;
+
+	static int root(std::vector<int>& parent, int v)
+	{
+		while (parent[v] != v)
+		{
+			parent[v] = parent[parent[v]];
+			v = parent[v];
+		}
+		return v;
+	}
+
+	// Iterative Tarjan over a CSR copy of the edges; no recursion so deep
+	// chains cannot overflow the stack.
+	void tarjan(const std::vector<int>& offsets, const std::vector<int>& targets)
+	{
+		int size = static_cast<int>(m_strong.size());
+		std::vector<int> index(size, -1);
+		std::vector<int> low(size, 0);
+		std::vector<int> next(size, 0);
+		std::vector<bool> onStack(size, false);
+		std::vector<int> stack;
+		std::vector<int> calls;
+		int counter = 0;
+
+		for (int s = 0; s < size; ++s)
+		{
+			if (index[s] >= 0)
+			{
+				continue;
+			}
+			calls.push_back(s);
+			while (!calls.empty())
+			{
+				int v = calls.back();
+				if (index[v] < 0)
+				{
+					index[v] = low[v] = counter++;
+					next[v] = offsets[v];
+					stack.push_back(v);
+					onStack[v] = true;
+				}
+				if (next[v] < offsets[v + 1])
+				{
+					int n = targets[next[v]++];
+					if (index[n] < 0)
+					{
+						calls.push_back(n);
+					}
+					else if (onStack[n] && index[n] < low[v])
+					{
+						low[v] = index[n];
+					}
+					continue;
+				}
+				// All edges of v done
+				calls.pop_back();
+				if (!calls.empty() && low[v] < low[calls.back()])
+				{
+					low[calls.back()] = low[v];
+				}
+				if (low[v] == index[v])
+				{
+					int w;
+					do
+					{
+						w = stack.back();
+						stack.pop_back();
+						onStack[w] = false;
+						m_strong[w] = m_strongCount;
+					} while (w != v);
+					++m_strongCount;
+				}
+			}
+		}
+	}
+
+public:
+	Components() : m_weakCount(0), m_strongCount(0) {};
+
+	template <class ForEachNeighbor>
+	Components(int size, ForEachNeighbor forEachNeighbor)
+		: m_weak(size), m_strong(size, -1), m_weakCount(0), m_strongCount(0)
+	{
+		std::vector<int> offsets(size + 1, 0);
+		std::vector<int> targets;
+		std::vector<int> parent(size);
+		for (int v = 0; v < size; ++v)
+		{
+			parent[v] = v;
+		}
+		for (int v = 0; v < size; ++v)
+		{
+			forEachNeighbor(v, [&](int n)
+			{
+				targets.push_back(n);
+				int a = root(parent, v);
+				int b = root(parent, n);
+				if (a != b)
+				{
+					parent[a] = b;
+				}
+			});
+			offsets[v + 1] = static_cast<int>(targets.size());
+		}
+
+		std::vector<int> label(size, -1);
+		for (int v = 0; v < size; ++v)
+		{
+			int r = root(parent, v);
+			if (label[r] < 0)
+			{
+				label[r] = m_weakCount++;
+			}
+			m_weak[v] = label[r];
+		}
+		tarjan(offsets, targets);
+	}
+
+	bool empty() const { return m_strong.empty(); };
+	int weak(int v) const { return m_weak[v]; };
+	int strong(int v) const { return m_strong[v]; };
+	int weakCount() const { return m_weakCount; };
+	int strongCount() const { return m_strongCount; };
+
+	// false: dst is certainly unreachable from src
+	bool mayReach(int src, int dst) const
+	{
+		return m_weak[src] == m_weak[dst] && m_strong[src] >= m_strong[dst];
+	}
+	// true: dst is certainly reachable from src
+	bool mustReach(int src, int dst) const
+	{
+		return m_strong[src] == m_strong[dst];
+	}
+};
+
+// Components of an m[i][j] matrix, non zero meaning an edge
+template <class Matrix>
+Components components(const Matrix& m, int size)
+{
+	return Components(size, [&m, size](int v, auto&& f)
+	{
+		for (int j = 0; j < size; ++j)
+		{
+			if (m[v][j])
+			{
+				f(j);
+			}
+		}
+	});
+}
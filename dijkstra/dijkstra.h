@@ -5,67 +5,37 @@ Class and method definitions for the Dijkstra's shortest path algorithm.
 #include <iostream>
 #include <chrono>
 #include <vector>
-#include <random>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <utility>
 
-// Some helper classes
-
-// Though not part of the assignment, the following class implements a Timer,
-// allowing you to check the runtime execution of the implementation.
-// Credit: http://www.learncpp.com/cpp-tutorial/8-16-timing-your-code/
-class Timer
-{
-private:
-	using clock_t = std::chrono::high_resolution_clock;
-	using second_t = std::chrono::duration<double, std::ratio<1>>;
-
-	std::chrono::time_point<clock_t> m_beg;
-
-public:
-	Timer() : m_beg(clock_t::now())
-	{}
-
-	void reset()
-	{
-		m_beg = clock_t::now();
-	}
+#include "../StaticLib1/timer.h"
+#include "../StaticLib1/random.h"
+#include "../StaticLib1/trace.h"
+#include "../StaticLib1/footprint.h"
+#include "stats.h"
+#include "executor.h"
 
-	double elapsed() const
-	{
-		return std::chrono::duration_cast<second_t>(clock_t::now() - m_beg).count();
-	}
-};
+// Some helper classes
 
-// A random generator to assist with random int and double values
-// Credit: http://www.learncpp.com/cpp-tutorial/59-random-number-generation/
-class Random
+// Read-only view over a run of ints owned by another object, e.g. the
+// neighbors of a vertex.  Valid until the owner is modified.
+class IdRange
 {
 private:
-	std::random_device m_rd;
-	std::mt19937 m_mersenne;
-
+	const int* m_first;
+	const int* m_last;
 public:
-	Random() { 
-		m_mersenne = std::mt19937(m_rd());
-	};
-	double getRandom(double start, double end)
-	{
-		std::uniform_real_distribution<double> dist{ start, end };
-
-		double result = dist(m_mersenne);
-		return result;
-	}
-
-	int getRandom(int start, int end)
-	{
-		std::uniform_int_distribution<int> dist{ start, end };
-
-		int result = dist(m_mersenne);
-		return result;
-	}
+	IdRange(const int* first, const int* last) : m_first(first), m_last(last) {};
+	const int* begin() const { return m_first; };
+	const int* end() const { return m_last; };
+	int size() const { return static_cast<int>(m_last - m_first); };
+	bool empty() const { return m_first == m_last; };
+	int operator[](int i) const { return m_first[i]; };
 };
 
-
-
 // Vertex ADT definition
 class Vertex
 {
@@ -74,13 +44,13 @@ private:
 	std::vector<int> m_neighbors;
 public:
 	Vertex(int id=0) :m_id(id) {};
-	int getID() { return m_id; };	
+	int getID() const { return m_id; };	
 	int degree() { return m_neighbors.size(); };
 	void addNeighbor(int id)
 	{
 		m_neighbors.push_back(id);
 	}
-	std::vector<int> neighbors() const { return m_neighbors; };
+	const std::vector<int>& neighbors() const { return m_neighbors; };
 
 	friend bool operator==(const Vertex &v1, const Vertex &v2)
 	{
@@ -102,9 +72,9 @@ private:
 public:
 	Edge(int e_src, int e_dst, int e_cost)
 	 :m_src(e_src), m_dst(e_dst), m_cost(e_cost) {}
-	int getSrc() { return m_src; };
-	int getDst() { return m_dst; };
-	int getCost() { return m_cost; };
+	int getSrc() const { return m_src; };
+	int getDst() const { return m_dst; };
+	int getCost() const { return m_cost; };
 
 	// We define two edges to be the same if the endpoints
 	// are the same - note: cost is excluded
@@ -125,26 +95,291 @@ public:
 // Graph ADT definition
 // A set of vertices with associated edges.  Each edge has a cost
 // value attached to it.
+//
+// The edges are kept in compressed sparse row form, as a struct of arrays
+// carved out of a single arena allocation:
+//	offsets[m_size + 1] - the edges of v are [offsets[v], offsets[v + 1])
+//	targets[m_edges]    - neighbor ids, sorted within each vertex
+//	costs[m_edges]      - cost of the matching target
+// so degree() is O(1), edgeCost()/adjacent() are a binary search over the
+// neighbors of the source, and there is no per-vertex heap allocation.
 class Graph
 {
 private:
-	std::vector<Vertex> m_nodes;
-	std::vector<Edge> m_edges;
+	footprint::Vector<int, footprint::Component::Graph> m_arena;
 	int m_size;
+	int m_edges;
 	double m_density;
+	footprint::GraphCopies m_copies;
+
+	const int* offsets() const { return m_arena.data(); };
+	const int* targets() const { return m_arena.data() + m_size + 1; };
+	const int* costs() const { return m_arena.data() + m_size + 1 + m_edges; };
+
+	// Position of the edge s -> d in the arena, or -1
+	int find(int s, int d) const
+	{
+		const int* first = targets() + offsets()[s];
+		const int* last = targets() + offsets()[s + 1];
+		const int* it = std::lower_bound(first, last, d);
+		if (it == last || *it != d)
+		{
+			return -1;
+		}
+		return static_cast<int>(it - targets());
+	}
+
+	// Lay out the arena from edges sorted by (src, dst)
+	void assign(const std::vector<Edge>& edges)
+	{
+		m_edges = static_cast<int>(edges.size());
+		m_arena.assign(m_size + 1 + 2 * m_edges, 0);
+		int* offset = m_arena.data();
+		int* target = offset + m_size + 1;
+		int* cost = target + m_edges;
+		for (int i = 0; i < m_edges; ++i)
+		{
+			++offset[edges[i].getSrc() + 1];
+			target[i] = edges[i].getDst();
+			cost[i] = edges[i].getCost();
+		}
+		for (int v = 0; v < m_size; ++v)
+		{
+			offset[v + 1] += offset[v];
+		}
+	}
 
 public:
 	Graph(int size=10, double density=0.1)
-		:m_size(size), m_density(density)
+		:m_arena(size + 1, 0), m_size(size), m_edges(0), m_density(density)
 	{};
-	double getDensity() { return m_density; };
-	int vertices() { return m_size; };
-	std::vector<int> neighbors(Vertex src) const;
-	int edgeCost(int s_id, int d_id);
-	bool adjacent(Vertex src, Vertex dst);
-	void generate();
-
-	friend std::ostream& operator<<(std::ostream& out, const Graph& g);
+	double getDensity() const { return m_density; };
+	int vertices() const { return m_size; };
+	int edges() const { return m_edges; };
+	// Heap bytes held by the graph
+	std::size_t memoryBytes() const { return m_arena.capacity() * sizeof(int); };
+	// 64 bit FNV-1a hash of the vertex count and the CSR arrays: equal
+	// graphs have equal checksums whatever process built them, so results
+	// saved for a graph can be matched to it again (tree_store.h).
+	std::uint64_t checksum() const
+	{
+		std::uint64_t h = 0xCBF29CE484222325ull;
+		auto mix = [&h](int word)
+		{
+			std::uint32_t w = static_cast<std::uint32_t>(word);
+			for (int b = 0; b < 4; ++b)
+			{
+				h = (h ^ ((w >> (8 * b)) & 0xFF)) * 0x100000001B3ull;
+			}
+		};
+		mix(m_size);
+		for (int word : m_arena)
+		{
+			mix(word);
+		}
+		return h;
+	}
+	int degree(int id) const { return offsets()[id + 1] - offsets()[id]; };
+	// Views into the arena; neighborCosts(v)[i] is the cost of the edge
+	// to neighbors(v)[i].
+	IdRange neighbors(const Vertex& src) const
+	{
+		int id = src.getID();
+		return IdRange(targets() + offsets()[id], targets() + offsets()[id + 1]);
+	}
+	IdRange neighborCosts(const Vertex& src) const
+	{
+		int id = src.getID();
+		return IdRange(costs() + offsets()[id], costs() + offsets()[id + 1]);
+	}
+	// Zero if there is no edge between s_id and d_id
+	int edgeCost(int s_id, int d_id) const
+	{
+		int pos = find(s_id, d_id);
+		return pos < 0 ? 0 : costs()[pos];
+	}
+	bool adjacent(const Vertex& src, const Vertex& dst) const
+	{
+		return find(src.getID(), dst.getID()) >= 0;
+	}
+
+	// Replace the edges of the graph.  Self loops, out of range endpoints
+	// and duplicates (the first one wins) are dropped.
+	void build(std::vector<Edge> edges)
+	{
+		int size = m_size;
+		auto invalid = [size](const Edge& e)
+		{
+			return e.getSrc() < 0 || e.getSrc() >= size ||
+				e.getDst() < 0 || e.getDst() >= size ||
+				e.getSrc() == e.getDst();
+		};
+		edges.erase(std::remove_if(edges.begin(), edges.end(), invalid), edges.end());
+		std::stable_sort(edges.begin(), edges.end(), [](const Edge& e1, const Edge& e2)
+		{
+			return e1.getSrc() < e2.getSrc() ||
+				(e1.getSrc() == e2.getSrc() && e1.getDst() < e2.getDst());
+		});
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+		assign(edges);
+	}
+
+	// Copy of the graph with a batch of changes applied: an edge with a
+	// cost adds the edge or replaces its cost, one with cost 0 removes it;
+	// the last change to an edge wins.  Invalid edges are dropped as in
+	// build().  The targets and costs of rows without changes are copied
+	// as whole runs, so a batch costs one pass over the arena.
+	Graph withChanges(std::vector<Edge> changes) const
+	{
+		int size = m_size;
+		changes.erase(std::remove_if(changes.begin(), changes.end(), [size](const Edge& e)
+		{
+			return e.getSrc() < 0 || e.getSrc() >= size ||
+				e.getDst() < 0 || e.getDst() >= size ||
+				e.getSrc() == e.getDst();
+		}), changes.end());
+		std::stable_sort(changes.begin(), changes.end(), [](const Edge& e1, const Edge& e2)
+		{
+			return e1.getSrc() < e2.getSrc() ||
+				(e1.getSrc() == e2.getSrc() && e1.getDst() < e2.getDst());
+		});
+		// Keep the last change of each edge
+		std::vector<Edge> last;
+		last.reserve(changes.size());
+		for (std::size_t i = 0; i < changes.size(); ++i)
+		{
+			if (i + 1 == changes.size() || !(changes[i] == changes[i + 1]))
+			{
+				last.push_back(changes[i]);
+			}
+		}
+
+		// Merge the changes of row v with its edges; emit(target, cost)
+		// is called for every edge of the new row, in target order.
+		auto merge = [this](int v, const Edge* first, const Edge* last, auto&& emit)
+		{
+			const int* t = targets() + offsets()[v];
+			const int* tEnd = targets() + offsets()[v + 1];
+			const int* c = costs() + offsets()[v];
+			while (t != tEnd || first != last)
+			{
+				if (first == last || (t != tEnd && *t < first->getDst()))
+				{
+					emit(*t++, *c++);
+					continue;
+				}
+				if (t != tEnd && *t == first->getDst())
+				{
+					++t;
+					++c;
+				}
+				if (first->getCost())
+				{
+					emit(first->getDst(), first->getCost());
+				}
+				++first;
+			}
+		};
+
+		// First pass: the degree of every row in the new graph
+		Graph g(m_size, m_density);
+		std::vector<int> degree(m_size);
+		std::size_t next = 0;
+		int edges = 0;
+		for (int v = 0; v < m_size; ++v)
+		{
+			std::size_t begin = next;
+			while (next < last.size() && last[next].getSrc() == v)
+			{
+				++next;
+			}
+			int d = 0;
+			if (begin == next)
+			{
+				d = offsets()[v + 1] - offsets()[v];
+			}
+			else
+			{
+				merge(v, &last[begin], last.data() + next, [&d](int, int) { ++d; });
+			}
+			degree[v] = d;
+			edges += d;
+		}
+
+		// Second pass: lay out the new arena
+		g.m_edges = edges;
+		g.m_arena.assign(m_size + 1 + 2 * static_cast<std::size_t>(edges), 0);
+		int* offset = g.m_arena.data();
+		int* target = offset + m_size + 1;
+		int* cost = target + edges;
+		next = 0;
+		for (int v = 0; v < m_size; ++v)
+		{
+			offset[v + 1] = offset[v] + degree[v];
+			std::size_t begin = next;
+			while (next < last.size() && last[next].getSrc() == v)
+			{
+				++next;
+			}
+			int at = offset[v];
+			if (begin == next)
+			{
+				std::copy(targets() + offsets()[v], targets() + offsets()[v + 1], target + at);
+				std::copy(costs() + offsets()[v], costs() + offsets()[v + 1], cost + at);
+			}
+			else
+			{
+				merge(v, &last[begin], last.data() + next, [&](int n, int c)
+				{
+					target[at] = n;
+					cost[at] = c;
+					++at;
+				});
+			}
+		}
+		return g;
+	}
+
+	// Generate a random graph based on the density.  Rows are produced in
+	// order, so the edge list is already sorted.  The edge draws and costs
+	// of a row come from the generator in two batches.
+	void generate(int minCost = 1, int maxCost = 10)
+	{
+		TRACE_SCOPE("generate");
+		Random r;
+		std::vector<Edge> edges;
+		edges.reserve(static_cast<std::size_t>(m_density * m_size * m_size) + m_size);
+		std::vector<double> draws(m_size);
+		std::vector<int> costs(m_size);
+		for (int i = 0; i < m_size; ++i)
+		{
+			r.stream().fill(draws.data(), draws.size(), 0.0, 1.0);
+			r.stream().fill(costs.data(), costs.size(), minCost, maxCost);
+			for (int j = 0; j < m_size; ++j)
+			{
+				// We do not support a loop
+				if (i != j && m_density > draws[j])
+				{
+					edges.push_back(Edge(i, j, costs[j]));
+				}
+			}
+		}
+		assign(edges);
+	}
+
+	friend std::ostream& operator<<(std::ostream& out, const Graph& g)
+	{
+		for (int v = 0; v < g.m_size; ++v)
+		{
+			out << v << ":";
+			for (int e = g.offsets()[v]; e < g.offsets()[v + 1]; ++e)
+			{
+				out << " " << g.targets()[e] << "(" << g.costs()[e] << ")";
+			}
+			out << std::endl;
+		}
+		return out;
+	}
 };
 
 // Set SDT
@@ -157,8 +392,8 @@ private:
 	int m_cost;
 public:
 	Set(int id, int cost) : m_id(id), m_cost(cost) {};
-	int id() { return m_id; };
-	int cost() { return m_cost; };
+	int id() const { return m_id; };
+	int cost() const { return m_cost; };
 	friend bool operator==(const Set& s1, const Set& s2)
 	{
 		// We do not equate the cost as that fluctuates
@@ -174,49 +409,307 @@ public:
 
 // PriorityQueue ADT
 // Implement to maintain the closed and open sets
+// Binary min-heap on cost, with the heap position of every id so that
+// contains() is O(1) and a cost can be lowered in place.  Once reserve()
+// has been called for the number of vertices, none of the operations
+// allocate.
 class PriorityQueue {
 private:
-	std::vector<Set> m_set;
+	footprint::Vector<Set, footprint::Component::Solver> m_set;
+	footprint::Vector<int, footprint::Component::Solver> m_position;
 
-	bool minimum(Set& min);
+	void place(int i, const Set& s)
+	{
+		m_set[i] = s;
+		m_position[s.id()] = i;
+	}
+	void up(int i)
+	{
+		Set s = m_set[i];
+		while (i > 0 && s.cost() < m_set[(i - 1) / 2].cost())
+		{
+			place(i, m_set[(i - 1) / 2]);
+			i = (i - 1) / 2;
+		}
+		place(i, s);
+	}
+	void down(int i)
+	{
+		Set s = m_set[i];
+		int n = static_cast<int>(m_set.size());
+		for (int child = 2 * i + 1; child < n; child = 2 * i + 1)
+		{
+			if (child + 1 < n && m_set[child + 1].cost() < m_set[child].cost())
+			{
+				++child;
+			}
+			if (!(m_set[child].cost() < s.cost()))
+			{
+				break;
+			}
+			place(i, m_set[child]);
+			i = child;
+		}
+		place(i, s);
+	}
 public:
-	bool contains(int id)
+	void reserve(int size)
+	{
+		m_set.reserve(size);
+		m_position.assign(size, -1);
+	}
+	// Empty the queue but keep the storage
+	void clear()
 	{
 		for (auto& elem : m_set)
 		{
-			if (id == elem.id())
+			m_position[elem.id()] = -1;
+		}
+		m_set.clear();
+	}
+	bool contains(int id) const
+	{
+		return id < static_cast<int>(m_position.size()) && m_position[id] >= 0;
+	}
+	void insert(const Set& s)
+	{
+		if (!contains(s.id()))
+		{
+			if (s.id() >= static_cast<int>(m_position.size()))
 			{
-				return true;
+				m_position.resize(s.id() + 1, -1);
 			}
+			m_set.push_back(s);
+			up(static_cast<int>(m_set.size()) - 1);
 		}
-		return false;
 	}
-	void insert(Set s)
+	// Lower the cost of s, inserting it if it is not queued yet
+	void decrease(const Set& s)
 	{
 		if (!contains(s.id()))
 		{
-			m_set.push_back(s);
+			insert(s);
+		}
+		else if (s.cost() < m_set[m_position[s.id()]].cost())
+		{
+			int i = m_position[s.id()];
+			place(i, s);
+			up(i);
+		}
+	}
+	bool minimum(Set& min) const
+	{
+		if (m_set.empty())
+		{
+			return false;
+		}
+		min = m_set.front();
+		return true;
+	}
+	// Remove the minimum cost entry
+	bool pop(Set& min)
+	{
+		if (!minimum(min))
+		{
+			return false;
 		}
+		m_position[min.id()] = -1;
+		Set last = m_set.back();
+		m_set.pop_back();
+		if (!m_set.empty())
+		{
+			place(0, last);
+			down(0);
+		}
+		return true;
+	}
+	bool isEmpty() const { return 0 == m_set.size(); };
+	int size() const { return static_cast<int>(m_set.size()); };
+	std::size_t memoryBytes() const
+	{
+		return m_set.capacity() * sizeof(Set) + m_position.capacity() * sizeof(int);
 	}
-	bool isEmpty() { return 0 == m_set.size(); };
 };
 
 
 // ShortestPath ADT
+// The graph is held through a shared pointer: several solvers can share
+// one graph, or a graph can be moved in, but it is never copied.  All
+// scratch storage is sized in the constructor so path() does not
+// allocate.
 class ShortestPath
 {
 private:
 	int m_totalCost;
-	Graph m_graph;
+	std::shared_ptr<const Graph> m_graph;
 	PriorityQueue m_openset;
 	PriorityQueue m_closedset;
+	footprint::Vector<int, footprint::Component::Solver> m_distance;
+	// Vertex before each vertex on its shortest route from the source
+	footprint::Vector<int, footprint::Component::Solver> m_previous;
+	// Counters of the last path() run, see stats.h
+	SolverStats m_stats;
+
+	// Dijkstra from s, stopping once d is settled; d = -1 settles every
+	// vertex reachable from s.
+	void search(int s, int d);
 public:
-	ShortestPath(Graph g) : m_graph(g), m_totalCost(0) {};
+	explicit ShortestPath(std::shared_ptr<const Graph> g)
+		: m_totalCost(0), m_graph(std::move(g))
+	{
+		int size = m_graph->vertices();
+		m_openset.reserve(size);
+		m_closedset.reserve(size);
+		m_distance.resize(size);
+		m_previous.resize(size);
+	};
+	explicit ShortestPath(Graph&& g)
+		: ShortestPath(std::make_shared<const Graph>(std::move(g)))
+	{};
 	~ShortestPath() {};
 
-	int vertices() { return m_graph.vertices(); };
-	bool path(Vertex src, Vertex dst);
-	int pathCost() { return m_totalCost; };
+	// Solve on another graph from now on, keeping the solver arrays when
+	// it has as many vertices; e.g. the latest snapshot (snapshot.h).
+	void rebind(std::shared_ptr<const Graph> g)
+	{
+		int size = g->vertices();
+		if (size != static_cast<int>(m_distance.size()))
+		{
+			m_openset = PriorityQueue();
+			m_closedset = PriorityQueue();
+			m_openset.reserve(size);
+			m_closedset.reserve(size);
+			m_distance.assign(size, 0);
+			m_previous.assign(size, 0);
+		}
+		m_graph = std::move(g);
+	}
+
+	int vertices() const { return m_graph->vertices(); };
+	const Graph& graph() const { return *m_graph; };
+	// Heap bytes of the solver's own state; the graph is shared
+	std::size_t memoryBytes() const
+	{
+		return m_openset.memoryBytes() + m_closedset.memoryBytes() +
+			(m_distance.capacity() + m_previous.capacity()) * sizeof(int);
+	}
+	bool path(const Vertex& src, const Vertex& dst);
+	// Shortest path tree of src: every reachable vertex settled, so
+	// pathCost(v) and previous(v) hold for all v afterwards.
+	void tree(const Vertex& src);
+	int pathCost() const { return m_totalCost; };
+	int pathCost(const Vertex& v) const { return m_distance[v.getID()]; };
+	// Vertex before v on its route, v itself for the source; only
+	// meaningful where pathCost(v) is finite.
+	int previous(const Vertex& v) const { return m_previous[v.getID()]; };
+	// Whole arrays of the last run, indexed by vertex id
+	const int* distances() const { return m_distance.data(); };
+	const int* predecessors() const { return m_previous.data(); };
+	const SolverStats& stats() const { return m_stats; };
 
 };
 
+// Dijkstra over the CSR arrays: pop the cheapest open vertex, close it and
+// relax the edges to its neighbors which are not closed yet.
+inline bool ShortestPath::path(const Vertex& src, const Vertex& dst)
+{
+	TRACE_SCOPE("path");
+	int d = dst.getID();
+	search(src.getID(), d);
+	m_totalCost = m_distance[d];
+	return m_totalCost != INT_MAX;
+}
+
+inline void ShortestPath::tree(const Vertex& src)
+{
+	TRACE_SCOPE("tree");
+	search(src.getID(), -1);
+	m_totalCost = 0;
+}
+
+inline void ShortestPath::search(int s, int d)
+{
+	m_stats = SolverStats();
+	STATS_ADD(m_stats, runs, 1);
+	STATS_ADD(m_stats, bytesTouched, m_distance.size() * sizeof(int));
+	std::fill(m_distance.begin(), m_distance.end(), INT_MAX);
+	m_openset.clear();
+	m_closedset.clear();
+
+	m_distance[s] = 0;
+	m_previous[s] = s;
+	m_openset.insert(Set(s, 0));
+	STATS_ADD(m_stats, queuePushes, 1);
+	Set m(s, 0);
+	while (m_openset.pop(m))
+	{
+		STATS_ADD(m_stats, queuePops, 1);
+		STATS_ADD(m_stats, verticesSettled, 1);
+		m_closedset.insert(m);
+		if (m.id() == d)
+		{
+			break;
+		}
+
+		IdRange ids = m_graph->neighbors(m.id());
+		IdRange costs = m_graph->neighborCosts(m.id());
+		STATS_ADD(m_stats, edgesScanned, ids.size());
+		// Neighbor id, cost, distance and closed set entry per edge
+		STATS_ADD(m_stats, bytesTouched, ids.size() * 4 * sizeof(int));
+		for (int i = 0; i < ids.size(); ++i)
+		{
+			int n = ids[i];
+			int dist = m.cost() + costs[i];
+			if (!m_closedset.contains(n) && dist < m_distance[n])
+			{
+				STATS_ADD(m_stats, relaxations, 1);
+				if (m_openset.contains(n))
+				{
+					STATS_ADD(m_stats, decreaseKeys, 1);
+				}
+				else
+				{
+					STATS_ADD(m_stats, queuePushes, 1);
+				}
+				m_distance[n] = dist;
+				m_previous[n] = m.id();
+				m_openset.decrease(Set(n, dist));
+			}
+		}
+	}
+	recordStats(m_stats);
+}
+
+
+// Asynchronous queries
+// Each query runs on an executor thread with its own solver over the
+// shared graph, so any number of queries can be in flight at once.
+struct PathResult
+{
+	bool found;
+	// INT_MAX if dst cannot be reached
+	int cost;
+};
+
+inline std::function<PathResult()> pathTask(std::shared_ptr<const Graph> g, int src, int dst)
+{
+	return [g, src, dst]()
+	{
+		ShortestPath sp(g);
+		bool found = sp.path(Vertex(src), Vertex(dst));
+		return PathResult{ found, sp.pathCost() };
+	};
+}
+
+inline std::future<PathResult> pathAsync(Executor& ex, std::shared_ptr<const Graph> g, int src, int dst)
+{
+	return ex.submit(pathTask(std::move(g), src, dst));
+}
+
+#ifdef GRAPH_COROUTINES
+// PathResult r = co_await awaitPath(ex, g, src, dst);
+inline Executor::Awaitable<PathResult> awaitPath(Executor& ex, std::shared_ptr<const Graph> g, int src, int dst)
+{
+	return ex.schedule(pathTask(std::move(g), src, dst));
+}
+#endif
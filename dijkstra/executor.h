@@ -0,0 +1,185 @@
+/*
+Executor for asynchronous graph work.
+
+A fixed pool of worker threads runs submitted tasks in FIFO order.
+submit() returns a std::future for the task's result (exceptions thrown
+by the task are rethrown by future::get()), so callers can keep many
+queries and graph loads in flight without a thread per request.
+
+When the compiler supports C++20 coroutines, schedule() returns an
+awaitable instead: the awaiting coroutine is suspended, the work runs on
+a pool thread and the coroutine is resumed on that thread with the
+result.  The test and loadgen projects are built as C++20 (toolset v142)
+so this path is compiled and tested; the others stay C++17.
+
+With pinned set, worker i only runs on the CPUs of NUMA node
+i % numa::nodes(), so a task's allocations are local to the node it runs
+on and numa::Replicated<T>::local() is the copy next to it.
+
+	Executor ex;
+	std::future<int> f = ex.submit([] { return 42; });
+	...
+	int v = co_await ex.schedule([] { return 42; });
+*/
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../StaticLib1/numa.h"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#include <optional>
+#define GRAPH_COROUTINES 1
+#endif
+#endif
+
+class Executor
+{
+private:
+	std::vector<std::thread> m_workers;
+	std::deque<std::function<void()>> m_tasks;
+	std::mutex m_lock;
+	std::condition_variable m_ready;
+	bool m_stopping;
+
+	void work()
+	{
+		for (;;)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> guard(m_lock);
+				m_ready.wait(guard, [this] { return m_stopping || !m_tasks.empty(); });
+				if (m_tasks.empty())
+				{
+					return;
+				}
+				task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+			}
+			task();
+		}
+	}
+
+public:
+	// threads = 0 uses one thread per hardware thread
+	explicit Executor(unsigned threads = 0, bool pinned = false) : m_stopping(false)
+	{
+		if (threads == 0)
+		{
+			threads = std::thread::hardware_concurrency();
+		}
+		if (threads == 0)
+		{
+			threads = 1;
+		}
+		for (unsigned i = 0; i < threads; ++i)
+		{
+			int node = pinned ? static_cast<int>(i % numa::nodes()) : -1;
+			m_workers.emplace_back([this, node]
+			{
+				if (node >= 0)
+				{
+					numa::pinThread(node);
+				}
+				work();
+			});
+		}
+	}
+
+	// Runs the tasks already submitted, then joins the workers
+	~Executor()
+	{
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			m_stopping = true;
+		}
+		m_ready.notify_all();
+		for (auto& t : m_workers)
+		{
+			t.join();
+		}
+	}
+	Executor(const Executor&) = delete;
+	Executor& operator=(const Executor&) = delete;
+
+	std::size_t threads() const { return m_workers.size(); };
+
+	// Fire and forget
+	void post(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			m_tasks.push_back(std::move(task));
+		}
+		m_ready.notify_one();
+	}
+
+	template <class F>
+	std::future<std::invoke_result_t<std::decay_t<F>>> submit(F&& f)
+	{
+		using R = std::invoke_result_t<std::decay_t<F>>;
+		// std::function needs a copyable target
+		auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+		std::future<R> result = task->get_future();
+		post([task] { (*task)(); });
+		return result;
+	}
+
+#ifdef GRAPH_COROUTINES
+	template <class R>
+	class Awaitable
+	{
+	private:
+		Executor& m_executor;
+		std::function<R()> m_work;
+		std::optional<R> m_result;
+		std::exception_ptr m_error;
+	public:
+		Awaitable(Executor& ex, std::function<R()> work) : m_executor(ex), m_work(std::move(work)) {};
+		bool await_ready() const noexcept { return false; };
+		void await_suspend(std::coroutine_handle<> h)
+		{
+			m_executor.post([this, h]
+			{
+				try
+				{
+					m_result.emplace(m_work());
+				}
+				catch (...)
+				{
+					m_error = std::current_exception();
+				}
+				h.resume();
+			});
+		}
+		R await_resume()
+		{
+			if (m_error)
+			{
+				std::rethrow_exception(m_error);
+			}
+			return std::move(*m_result);
+		}
+	};
+
+	template <class F>
+	Awaitable<std::invoke_result_t<std::decay_t<F>>> schedule(F&& f)
+	{
+		using R = std::invoke_result_t<std::decay_t<F>>;
+		static_assert(!std::is_void<R>::value, "schedule() needs a task returning a value");
+		return Awaitable<R>(*this, std::forward<F>(f));
+	}
+#endif
+};
@@ -0,0 +1,689 @@
+/*
+Compile time specialised graph.
+
+graph::Graph<Cost, Directed, Storage> fixes the cost type, the
+directedness and the storage layout at compile time, so the solvers below
+are instantiated with the inner loops specialised for each combination:
+
+	Dense     - flat V x V matrix, size given at run time
+	Csr       - compressed sparse rows, size given at run time
+	Compressed - gap and varint encoded rows, integral costs only: one to
+	             three bytes per edge instead of the eight of Csr
+	Fixed<N>  - std::array backed V x V matrix with N known at compile time
+
+As in the other graphs a cost of zero (Cost{}) means there is no edge.
+
+Compressed storage trades a little decode time in forEachNeighbor for
+less memory and memory bandwidth; build the graph as another storage
+and take Graph::copyOf it, or add the edges in row order.
+
+With Fixed<N> storage every operation is constexpr, so small graphs can be
+solved by the compiler and the results baked into the binary, e.g.
+
+	constexpr auto table = graph::allPairs(makeRoadGraph());
+*/
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace graph
+{
+	// Storage selectors
+	struct Dense {};
+	struct Csr {};
+	struct Compressed {};
+	template <int N> struct Fixed {};
+
+	// Flat row major V x V matrix
+	template <class Cost>
+	class DenseStorage
+	{
+	private:
+		std::vector<Cost> m_cells;
+		int m_size;
+	public:
+		explicit DenseStorage(int size) : m_cells(static_cast<std::size_t>(size) * size), m_size(size) {};
+		int size() const { return m_size; };
+		Cost cost(int s, int d) const { return m_cells[static_cast<std::size_t>(s) * m_size + d]; };
+		void set(int s, int d, Cost c) { m_cells[static_cast<std::size_t>(s) * m_size + d] = c; };
+		std::size_t memoryBytes() const { return m_cells.capacity() * sizeof(Cost); };
+		void shrink() {};
+
+		template <class F>
+		void forEachNeighbor(int v, F&& f) const
+		{
+			const Cost* row = &m_cells[static_cast<std::size_t>(v) * m_size];
+			for (int j = 0; j < m_size; ++j)
+			{
+				if (row[j] != Cost{})
+				{
+					f(j, row[j]);
+				}
+			}
+		}
+	};
+
+	// Compressed sparse rows, targets sorted within each row
+	template <class Cost>
+	class CsrStorage
+	{
+	private:
+		std::vector<int> m_offsets;
+		std::vector<int> m_targets;
+		std::vector<Cost> m_costs;
+
+		// First position in row s with a target >= d
+		int lowerBound(int s, int d) const
+		{
+			int first = m_offsets[s];
+			int count = m_offsets[s + 1] - first;
+			while (count > 0)
+			{
+				int half = count / 2;
+				if (m_targets[first + half] < d)
+				{
+					first += half + 1;
+					count -= half + 1;
+				}
+				else
+				{
+					count = half;
+				}
+			}
+			return first;
+		}
+	public:
+		explicit CsrStorage(int size) : m_offsets(size + 1, 0) {};
+		int size() const { return static_cast<int>(m_offsets.size()) - 1; };
+		Cost cost(int s, int d) const
+		{
+			int pos = lowerBound(s, d);
+			return (pos < m_offsets[s + 1] && m_targets[pos] == d) ? m_costs[pos] : Cost{};
+		}
+		// O(E) per new edge; meant for building small graphs and for
+		// updates.  Setting a zero cost removes the edge.
+		void set(int s, int d, Cost c)
+		{
+			int pos = lowerBound(s, d);
+			bool exists = pos < m_offsets[s + 1] && m_targets[pos] == d;
+			if (exists && c != Cost{})
+			{
+				m_costs[pos] = c;
+			}
+			else if (exists)
+			{
+				m_targets.erase(m_targets.begin() + pos);
+				m_costs.erase(m_costs.begin() + pos);
+				for (int v = s + 1; v <= size(); ++v)
+				{
+					--m_offsets[v];
+				}
+			}
+			else if (c != Cost{})
+			{
+				m_targets.insert(m_targets.begin() + pos, d);
+				m_costs.insert(m_costs.begin() + pos, c);
+				for (int v = s + 1; v <= size(); ++v)
+				{
+					++m_offsets[v];
+				}
+			}
+		}
+
+		std::size_t memoryBytes() const
+		{
+			return (m_offsets.capacity() + m_targets.capacity()) * sizeof(int) + m_costs.capacity() * sizeof(Cost);
+		}
+		void shrink()
+		{
+			m_targets.shrink_to_fit();
+			m_costs.shrink_to_fit();
+		}
+
+		template <class F>
+		void forEachNeighbor(int v, F&& f) const
+		{
+			for (int e = m_offsets[v]; e < m_offsets[v + 1]; ++e)
+			{
+				f(m_targets[e], m_costs[e]);
+			}
+		}
+	};
+
+	// Gap and varint encoded rows
+	// Each edge is one LEB128 varint of (gap << 4) | c, where gap is the
+	// distance from the previous target of the row less one (the first
+	// target counts from -1) and c is the cost when it is 1 to 15, as for
+	// the generated graphs.  Any other cost is written as c = 0 followed by
+	// its zigzag varint.  With sorted targets the gaps are small, so most
+	// edges take one or two bytes.
+	// The rows follow each other in one byte stream.  Rows after the last
+	// one written are empty and have no offset yet, hence adding edges in
+	// row and target order only ever appends; any other change re-encodes
+	// the row and moves the rest of the stream, O(E) like Csr.
+	template <class Cost>
+	class CompressedStorage
+	{
+	private:
+		static_assert(std::is_integral<Cost>::value, "Compressed storage needs integral costs");
+		std::vector<unsigned char> m_bytes;
+		// Start of the rows written so far
+		std::vector<std::size_t> m_offsets;
+		int m_size;
+		// Last target of the last row written, -1 if none
+		int m_last;
+
+		static void put(std::vector<unsigned char>& out, std::uint64_t v)
+		{
+			while (v >= 0x80)
+			{
+				out.push_back(static_cast<unsigned char>(v | 0x80));
+				v >>= 7;
+			}
+			out.push_back(static_cast<unsigned char>(v));
+		}
+		static std::uint64_t get(const unsigned char*& p)
+		{
+			std::uint64_t v = 0;
+			for (int shift = 0; ; shift += 7)
+			{
+				unsigned char b = *p++;
+				v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+				if (b < 0x80)
+				{
+					return v;
+				}
+			}
+		}
+		static void encode(std::vector<unsigned char>& out, int prev, int d, Cost c)
+		{
+			std::uint64_t gap = static_cast<std::uint64_t>(d - prev - 1);
+			if (c > 0 && c < 16)
+			{
+				put(out, (gap << 4) | static_cast<std::uint64_t>(c));
+			}
+			else
+			{
+				std::int64_t w = static_cast<std::int64_t>(c);
+				put(out, gap << 4);
+				put(out, (static_cast<std::uint64_t>(w) << 1) ^ static_cast<std::uint64_t>(w >> 63));
+			}
+		}
+		// Cost of the edge whose code was just read
+		static Cost decodeCost(std::uint64_t code, const unsigned char*& p)
+		{
+			if (code & 15)
+			{
+				return static_cast<Cost>(code & 15);
+			}
+			std::uint64_t z = get(p);
+			return static_cast<Cost>(static_cast<std::int64_t>(z >> 1) ^ -static_cast<std::int64_t>(z & 1));
+		}
+		std::size_t rowBegin(int v) const
+		{
+			return v < static_cast<int>(m_offsets.size()) ? m_offsets[v] : m_bytes.size();
+		}
+		std::size_t rowEnd(int v) const { return rowBegin(v + 1); };
+
+	public:
+		explicit CompressedStorage(int size) : m_size(size), m_last(-1) {};
+		int size() const { return m_size; };
+		// O(degree of s)
+		Cost cost(int s, int d) const
+		{
+			const unsigned char* p = m_bytes.data() + rowBegin(s);
+			const unsigned char* end = m_bytes.data() + rowEnd(s);
+			int n = -1;
+			while (p < end)
+			{
+				std::uint64_t code = get(p);
+				n += static_cast<int>(code >> 4) + 1;
+				Cost c = decodeCost(code, p);
+				if (n >= d)
+				{
+					return n == d ? c : Cost{};
+				}
+			}
+			return Cost{};
+		}
+		void set(int s, int d, Cost c)
+		{
+			int written = static_cast<int>(m_offsets.size());
+			if (s >= written || (s == written - 1 && d > m_last))
+			{
+				if (c == Cost{})
+				{
+					return;
+				}
+				while (static_cast<int>(m_offsets.size()) <= s)
+				{
+					m_offsets.push_back(m_bytes.size());
+					m_last = -1;
+				}
+				encode(m_bytes, m_last, d, c);
+				m_last = d;
+				return;
+			}
+
+			std::vector<std::pair<int, Cost>> row;
+			forEachNeighbor(s, [&row](int n, Cost cost) { row.emplace_back(n, cost); });
+			auto it = std::lower_bound(row.begin(), row.end(), d, [](const std::pair<int, Cost>& e, int id)
+			{
+				return e.first < id;
+			});
+			bool exists = it != row.end() && it->first == d;
+			if (exists && c != Cost{})
+			{
+				it->second = c;
+			}
+			else if (exists)
+			{
+				row.erase(it);
+			}
+			else if (c != Cost{})
+			{
+				row.insert(it, std::make_pair(d, c));
+			}
+			else
+			{
+				return;
+			}
+
+			std::vector<unsigned char> bytes;
+			int prev = -1;
+			for (auto& e : row)
+			{
+				encode(bytes, prev, e.first, e.second);
+				prev = e.first;
+			}
+			std::size_t first = rowBegin(s);
+			std::size_t last = rowEnd(s);
+			m_bytes.erase(m_bytes.begin() + first, m_bytes.begin() + last);
+			m_bytes.insert(m_bytes.begin() + first, bytes.begin(), bytes.end());
+			for (int v = s + 1; v < written; ++v)
+			{
+				m_offsets[v] = m_offsets[v] + bytes.size() - (last - first);
+			}
+			if (s == written - 1)
+			{
+				m_last = prev;
+			}
+		}
+		std::size_t memoryBytes() const
+		{
+			return m_bytes.capacity() + m_offsets.capacity() * sizeof(std::size_t);
+		}
+		void shrink()
+		{
+			m_bytes.shrink_to_fit();
+			m_offsets.shrink_to_fit();
+		}
+
+		// Decodes eight edges at a time while the next eight bytes are all
+		// one byte codes with the cost inline, the common case for dense
+		// or reordered graphs; the bytes are tested together as one word
+		// (little endian) rather than one by one.
+		template <class F>
+		void forEachNeighbor(int v, F&& f) const
+		{
+			const std::uint64_t high = 0x8080808080808080ull;
+			const std::uint64_t low = 0x0f0f0f0f0f0f0f0full;
+			const std::uint64_t ones = 0x0101010101010101ull;
+			const unsigned char* p = m_bytes.data() + rowBegin(v);
+			const unsigned char* end = m_bytes.data() + rowEnd(v);
+			int n = -1;
+			while (p < end)
+			{
+				if (end - p >= 8)
+				{
+					std::uint64_t w;
+					std::memcpy(&w, p, sizeof(w));
+					std::uint64_t costs = w & low;
+					// A byte with its high bit set, or a zero cost nibble
+					if (((w & high) | ((costs - ones) & ~costs & high)) == 0)
+					{
+						for (int k = 0; k < 8; ++k)
+						{
+							unsigned b = static_cast<unsigned>(w >> (8 * k)) & 0xff;
+							n += static_cast<int>(b >> 4) + 1;
+							f(n, static_cast<Cost>(b & 15));
+						}
+						p += 8;
+						continue;
+					}
+				}
+				std::uint64_t code = get(p);
+				n += static_cast<int>(code >> 4) + 1;
+				f(n, decodeCost(code, p));
+			}
+		}
+	};
+
+	// std::array backed matrix, usable in constant expressions
+	template <class Cost, int N>
+	class FixedStorage
+	{
+	private:
+		std::array<Cost, N * N> m_cells{};
+	public:
+		constexpr explicit FixedStorage(int size = N) { assert(size == N); (void)size; };
+		constexpr int size() const { return N; };
+		constexpr Cost cost(int s, int d) const { return m_cells[s * N + d]; };
+		constexpr void set(int s, int d, Cost c) { m_cells[s * N + d] = c; };
+		constexpr std::size_t memoryBytes() const { return 0; };
+		constexpr void shrink() {};
+
+		template <class F>
+		constexpr void forEachNeighbor(int v, F&& f) const
+		{
+			for (int j = 0; j < N; ++j)
+			{
+				if (m_cells[v * N + j] != Cost{})
+				{
+					f(j, m_cells[v * N + j]);
+				}
+			}
+		}
+	};
+
+	// Map a selector to its storage and to the per-vertex array type used
+	// by the solvers.
+	template <class Cost, class Storage> struct StorageTraits;
+
+	template <class Cost> struct StorageTraits<Cost, Dense>
+	{
+		using type = DenseStorage<Cost>;
+		template <class T> using array = std::vector<T>;
+		static constexpr int fixedSize = 0;
+	};
+	template <class Cost> struct StorageTraits<Cost, Csr>
+	{
+		using type = CsrStorage<Cost>;
+		template <class T> using array = std::vector<T>;
+		static constexpr int fixedSize = 0;
+	};
+	template <class Cost> struct StorageTraits<Cost, Compressed>
+	{
+		using type = CompressedStorage<Cost>;
+		template <class T> using array = std::vector<T>;
+		static constexpr int fixedSize = 0;
+	};
+	template <class Cost, int N> struct StorageTraits<Cost, Fixed<N>>
+	{
+		using type = FixedStorage<Cost, N>;
+		template <class T> using array = std::array<T, N>;
+		static constexpr int fixedSize = N;
+	};
+
+	// A per-vertex array: std::array for fixed graphs, std::vector otherwise
+	template <class T, int N>
+	constexpr auto makeArray(int size, T value)
+	{
+		if constexpr (N > 0)
+		{
+			std::array<T, N> a{};
+			for (int i = 0; i < N; ++i)
+			{
+				a[i] = value;
+			}
+			return a;
+		}
+		else
+		{
+			return std::vector<T>(size, value);
+		}
+	}
+
+
+	// Graph ADT definition
+	template <class Cost = int, bool Directed = true, class Storage = Dense>
+	class Graph
+	{
+	private:
+		using traits = StorageTraits<Cost, Storage>;
+		typename traits::type m_storage;
+
+	public:
+		using cost_type = Cost;
+		template <class T> using array_type = typename traits::template array<T>;
+		static constexpr bool directed = Directed;
+		static constexpr int fixedSize = traits::fixedSize;
+
+		constexpr explicit Graph(int size = fixedSize) : m_storage(size) {};
+
+		constexpr int vertices() const { return m_storage.size(); };
+		constexpr Cost cost(int s, int d) const { return m_storage.cost(s, d); };
+		constexpr bool adjacent(int s, int d) const { return m_storage.cost(s, d) != Cost{}; };
+		// Heap bytes held by the storage; zero for Fixed<N>
+		constexpr std::size_t memoryBytes() const { return m_storage.memoryBytes(); };
+		// Give back the spare capacity left by adding edges
+		constexpr void shrink() { m_storage.shrink(); };
+
+		// Copy of any graph with vertices() and forEachNeighbor(v, f), e.g.
+		// to compress a graph once it is built.  The edges are copied as
+		// stored, in neighbor order, so compressed storage just appends.
+		template <class G>
+		static Graph copyOf(const G& g)
+		{
+			Graph copy(g.vertices());
+			for (int v = 0; v < g.vertices(); ++v)
+			{
+				g.forEachNeighbor(v, [&copy, v](int n, auto c)
+				{
+					copy.m_storage.set(v, n, static_cast<Cost>(c));
+				});
+			}
+			copy.shrink();
+			return copy;
+		}
+
+		// An undirected graph stores both directions
+		constexpr void addEdge(int s, int d, Cost c)
+		{
+			m_storage.set(s, d, c);
+			if constexpr (!Directed)
+			{
+				m_storage.set(d, s, c);
+			}
+		}
+		constexpr void removeEdge(int s, int d) { addEdge(s, d, Cost{}); };
+
+		// f(neighbor, cost) for every edge leaving v
+		template <class F>
+		constexpr void forEachNeighbor(int v, F&& f) const
+		{
+			m_storage.forEachNeighbor(v, f);
+		}
+	};
+
+
+	// ShortestPath ADT
+	// Same algorithm as the matrix ShortestPath in dijkstra.cpp: repeatedly
+	// settle the cheapest unvisited vertex and relax its edges.  No heap,
+	// so it can run at compile time for Fixed<N> graphs.
+	template <class G>
+	class ShortestPath
+	{
+	public:
+		using Cost = typename G::cost_type;
+		static constexpr Cost infinity = std::numeric_limits<Cost>::max();
+
+	private:
+		const G& m_graph;
+		typename G::template array_type<Cost> m_distance;
+		typename G::template array_type<bool> m_visited;
+
+		constexpr int minimum() const
+		{
+			Cost min_value = infinity;
+			int min_index = -1;
+			for (int i = 0; i < m_graph.vertices(); ++i)
+			{
+				if (!m_visited[i] && m_distance[i] < min_value)
+				{
+					min_value = m_distance[i];
+					min_index = i;
+				}
+			}
+			return min_index;
+		}
+
+	public:
+		constexpr explicit ShortestPath(const G& g)
+			: m_graph(g),
+			m_distance(makeArray<Cost, G::fixedSize>(g.vertices(), infinity)),
+			m_visited(makeArray<bool, G::fixedSize>(g.vertices(), false))
+		{};
+
+		// Distances from src to every vertex; true if dst is reachable.
+		constexpr bool path(int src, int dst)
+		{
+			for (int i = 0; i < m_graph.vertices(); ++i)
+			{
+				m_distance[i] = infinity;
+				m_visited[i] = false;
+			}
+			m_distance[src] = Cost{};
+
+			for (int m = minimum(); m >= 0; m = minimum())
+			{
+				m_visited[m] = true;
+				Cost base = m_distance[m];
+				auto& distance = m_distance;
+				auto& visited = m_visited;
+				m_graph.forEachNeighbor(m, [&](int n, Cost c)
+				{
+					if (!visited[n] && base + c < distance[n])
+					{
+						distance[n] = base + c;
+					}
+				});
+			}
+			return m_distance[dst] != infinity;
+		}
+		constexpr Cost pathCost(int n) const { return m_distance[n]; };
+		constexpr const auto& distances() const { return m_distance; };
+	};
+
+
+	// MST ADT
+	// Prim on an undirected graph.  The first tree is rooted at vertex 0;
+	// each vertex it does not reach roots another, so a disconnected graph
+	// gets a spanning forest.
+	template <class G>
+	class MST
+	{
+	public:
+		using Cost = typename G::cost_type;
+		static constexpr Cost infinity = std::numeric_limits<Cost>::max();
+
+	private:
+		static_assert(!G::directed, "A spanning tree needs an undirected graph");
+		const G& m_graph;
+		typename G::template array_type<Cost> m_cost;
+		typename G::template array_type<bool> m_visited;
+		typename G::template array_type<int> m_mst;
+
+		constexpr int minimum() const
+		{
+			Cost min_value = infinity;
+			int min_index = -1;
+			for (int i = 0; i < m_graph.vertices(); ++i)
+			{
+				if (!m_visited[i] && m_cost[i] < min_value)
+				{
+					min_value = m_cost[i];
+					min_index = i;
+				}
+			}
+			return min_index;
+		}
+
+	public:
+		constexpr explicit MST(const G& g)
+			: m_graph(g),
+			m_cost(makeArray<Cost, G::fixedSize>(g.vertices(), infinity)),
+			m_visited(makeArray<bool, G::fixedSize>(g.vertices(), false)),
+			m_mst(makeArray<int, G::fixedSize>(g.vertices(), -1))
+		{};
+
+		constexpr void prim()
+		{
+			for (int root = 0; root < m_graph.vertices(); ++root)
+			{
+				if (m_visited[root])
+				{
+					continue;
+				}
+				m_cost[root] = Cost{};
+				for (int m = minimum(); m >= 0; m = minimum())
+				{
+					m_visited[m] = true;
+					auto& cost = m_cost;
+					auto& visited = m_visited;
+					auto& mst = m_mst;
+					m_graph.forEachNeighbor(m, [&](int n, Cost c)
+					{
+						if (!visited[n] && c < cost[n])
+						{
+							mst[n] = m;
+							cost[n] = c;
+						}
+					});
+				}
+			}
+		}
+		// Parent of v in its tree, -1 for the root of each tree
+		constexpr int parent(int v) const { return m_mst[v]; };
+		// Total cost of the tree, or spanning forest if disconnected
+		constexpr Cost cost() const
+		{
+			Cost total{};
+			for (int i = 0; i < m_graph.vertices(); ++i)
+			{
+				if (m_mst[i] >= 0)
+				{
+					total += m_cost[i];
+				}
+			}
+			return total;
+		}
+	};
+
+
+	// Shortest distances from src to every vertex
+	template <class G>
+	constexpr auto shortestDistances(const G& g, int src)
+	{
+		ShortestPath<G> sp(g);
+		sp.path(src, src);
+		return sp.distances();
+	}
+
+	// Distance table for every pair of vertices of a fixed size graph
+	template <class Cost, bool Directed, int N>
+	constexpr auto allPairs(const Graph<Cost, Directed, Fixed<N>>& g)
+	{
+		std::array<std::array<Cost, N>, N> table{};
+		for (int s = 0; s < N; ++s)
+		{
+			table[s] = shortestDistances(g, s);
+		}
+		return table;
+	}
+
+	template <class G>
+	constexpr auto spanningTreeCost(const G& g)
+	{
+		MST<G> mst(g);
+		mst.prim();
+		return mst.cost();
+	}
+}
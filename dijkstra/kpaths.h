@@ -0,0 +1,351 @@
+/*
+K shortest loopless paths (Yen).
+
+Path k+1 is the cheapest of the candidates made by taking a prefix (the
+root) of path k, and joining it to dst by a "spur" search from the last
+root vertex which avoids the root vertices and the next edge of every
+accepted path sharing that root.
+
+What makes it cheap compared to K * V full searches:
+	- One reverse Dijkstra from dst gives the exact distance of every
+	  vertex to dst.  It is reused as the A* lower bound of every spur
+	  search (removing vertices and edges only makes distances longer, so
+	  it stays admissible), which then mostly walks straight to dst.  The
+	  first path is read straight off the same tree.
+	- Scratch arrays are allocated once per worker and reset with a stamp
+	  rather than cleared.
+	- The spur searches of one round are independent and are spread over
+	  an Executor when one is given.
+	- Candidates wait in a heap; duplicates are dropped on insertion.
+
+The graph is copied into forward and reverse CSR arrays at construction
+from forEachEdge(v, f), calling f(n, cost) for every edge v -> n.
+*/
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <future>
+#include <queue>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "executor.h"
+#include "../StaticLib1/trace.h"
+
+// A path and its total cost
+struct Route
+{
+	int cost;
+	std::vector<int> vertices;
+
+	bool operator>(const Route& r) const
+	{
+		return cost != r.cost ? cost > r.cost : vertices > r.vertices;
+	}
+};
+
+class KShortestPaths
+{
+private:
+	// Per worker search state, valid where the stamp matches
+	struct Scratch
+	{
+		std::vector<int> distance;
+		std::vector<int> previous;
+		std::vector<unsigned> seen;
+		std::vector<unsigned> blocked;
+		std::vector<unsigned> closed;
+		std::vector<std::pair<int, int>> heap;
+		unsigned stamp = 0;
+
+		void reset(int size)
+		{
+			if (static_cast<int>(seen.size()) != size)
+			{
+				distance.assign(size, 0);
+				previous.assign(size, 0);
+				seen.assign(size, 0);
+				blocked.assign(size, 0);
+				closed.assign(size, 0);
+				stamp = 0;
+			}
+			if (++stamp == 0)
+			{
+				std::fill(seen.begin(), seen.end(), 0);
+				std::fill(blocked.begin(), blocked.end(), 0);
+				std::fill(closed.begin(), closed.end(), 0);
+				stamp = 1;
+			}
+			heap.clear();
+		}
+	};
+
+	std::vector<int> m_offsets;
+	std::vector<int> m_targets;
+	std::vector<int> m_costs;
+	std::vector<int> m_reverseOffsets;
+	std::vector<int> m_sources;
+	std::vector<int> m_reverseCosts;
+	// Distance to, and next vertex towards, m_dst
+	std::vector<int> m_toDst;
+	std::vector<int> m_next;
+	int m_dst;
+	std::vector<Scratch> m_scratch;
+	Executor* m_executor;
+
+	int vertices() const { return static_cast<int>(m_offsets.size()) - 1; };
+
+	// Reverse Dijkstra from dst; kept until a query for another dst
+	void buildTree(int dst)
+	{
+		if (m_dst == dst)
+		{
+			return;
+		}
+		m_dst = dst;
+		std::fill(m_toDst.begin(), m_toDst.end(), INT_MAX);
+		std::fill(m_next.begin(), m_next.end(), -1);
+		using Entry = std::pair<int, int>;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+		m_toDst[dst] = 0;
+		open.push(Entry(0, dst));
+		while (!open.empty())
+		{
+			Entry e = open.top();
+			open.pop();
+			int v = e.second;
+			if (e.first > m_toDst[v])
+			{
+				continue;
+			}
+			for (int i = m_reverseOffsets[v]; i < m_reverseOffsets[v + 1]; ++i)
+			{
+				int u = m_sources[i];
+				int dist = e.first + m_reverseCosts[i];
+				if (dist < m_toDst[u])
+				{
+					m_toDst[u] = dist;
+					m_next[u] = v;
+					open.push(Entry(dist, u));
+				}
+			}
+		}
+	}
+
+	// A* from the spur vertex to m_dst avoiding blocked vertices and the
+	// edges spur -> n for n in bannedNext.  Appends the spur path to
+	// route (which holds the root up to the spur vertex).
+	bool spur(Scratch& s, const std::vector<int>& root, int rootCost,
+		const std::vector<int>& bannedNext, Route& route) const
+	{
+		int size = vertices();
+		s.reset(size);
+		int from = root.back();
+		for (std::size_t i = 0; i + 1 < root.size(); ++i)
+		{
+			s.blocked[root[i]] = s.stamp;
+		}
+
+		auto later = [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first > b.first; };
+		s.distance[from] = 0;
+		s.previous[from] = from;
+		s.seen[from] = s.stamp;
+		s.heap.push_back(std::make_pair(m_toDst[from], from));
+		while (!s.heap.empty())
+		{
+			std::pop_heap(s.heap.begin(), s.heap.end(), later);
+			int v = s.heap.back().second;
+			s.heap.pop_back();
+			if (s.closed[v] == s.stamp)
+			{
+				continue;
+			}
+			s.closed[v] = s.stamp;
+			if (v == m_dst)
+			{
+				break;
+			}
+			for (int i = m_offsets[v]; i < m_offsets[v + 1]; ++i)
+			{
+				int n = m_targets[i];
+				if (s.blocked[n] == s.stamp || s.closed[n] == s.stamp || m_toDst[n] == INT_MAX)
+				{
+					continue;
+				}
+				if (v == from && std::find(bannedNext.begin(), bannedNext.end(), n) != bannedNext.end())
+				{
+					continue;
+				}
+				int dist = s.distance[v] + m_costs[i];
+				if (s.seen[n] != s.stamp || dist < s.distance[n])
+				{
+					s.seen[n] = s.stamp;
+					s.distance[n] = dist;
+					s.previous[n] = v;
+					s.heap.push_back(std::make_pair(dist + m_toDst[n], n));
+					std::push_heap(s.heap.begin(), s.heap.end(), later);
+				}
+			}
+		}
+		if (s.closed[m_dst] != s.stamp)
+		{
+			return false;
+		}
+
+		route.vertices = root;
+		std::size_t joint = route.vertices.size();
+		for (int v = m_dst; v != from; v = s.previous[v])
+		{
+			route.vertices.push_back(v);
+		}
+		std::reverse(route.vertices.begin() + joint, route.vertices.end());
+		route.cost = rootCost + s.distance[m_dst];
+		return true;
+	}
+
+	// Cost of the edge s -> d, which must exist
+	int edgeCost(int s, int d) const
+	{
+		for (int i = m_offsets[s]; i < m_offsets[s + 1]; ++i)
+		{
+			if (m_targets[i] == d)
+			{
+				return m_costs[i];
+			}
+		}
+		return INT_MAX;
+	}
+
+public:
+	// executor = nullptr runs the spur searches on the calling thread
+	template <class ForEachEdge>
+	KShortestPaths(int size, ForEachEdge forEachEdge, Executor* executor = nullptr)
+		: m_offsets(size + 1, 0), m_reverseOffsets(size + 1, 0),
+		m_toDst(size, INT_MAX), m_next(size, -1), m_dst(-1),
+		m_scratch(executor ? executor->threads() : 1), m_executor(executor)
+	{
+		for (int v = 0; v < size; ++v)
+		{
+			forEachEdge(v, [&](int n, int cost)
+			{
+				m_targets.push_back(n);
+				m_costs.push_back(cost);
+				++m_reverseOffsets[n + 1];
+			});
+			m_offsets[v + 1] = static_cast<int>(m_targets.size());
+		}
+		for (int v = 0; v < size; ++v)
+		{
+			m_reverseOffsets[v + 1] += m_reverseOffsets[v];
+		}
+		m_sources.resize(m_targets.size());
+		m_reverseCosts.resize(m_targets.size());
+		std::vector<int> fill(m_reverseOffsets.begin(), m_reverseOffsets.end() - 1);
+		for (int v = 0; v < size; ++v)
+		{
+			for (int i = m_offsets[v]; i < m_offsets[v + 1]; ++i)
+			{
+				int pos = fill[m_targets[i]]++;
+				m_sources[pos] = v;
+				m_reverseCosts[pos] = m_costs[i];
+			}
+		}
+	}
+
+	// Up to k loopless paths from src to dst in increasing cost order
+	std::vector<Route> find(int src, int dst, int k)
+	{
+		TRACE_SCOPE("kpaths");
+		std::vector<Route> accepted;
+		buildTree(dst);
+		if (k <= 0 || m_toDst[src] == INT_MAX)
+		{
+			return accepted;
+		}
+
+		Route first{ m_toDst[src], { src } };
+		for (int v = src; v != dst; v = m_next[v])
+		{
+			first.vertices.push_back(m_next[v]);
+		}
+		accepted.push_back(first);
+
+		std::priority_queue<Route, std::vector<Route>, std::greater<Route>> candidates;
+		std::set<std::vector<int>> known{ first.vertices };
+		std::vector<Route> found;
+		// char, not bool: written concurrently by the workers
+		std::vector<char> ok;
+
+		while (static_cast<int>(accepted.size()) < k)
+		{
+			const std::vector<int> last = accepted.back().vertices;
+			int spurs = static_cast<int>(last.size()) - 1;
+			std::vector<int> rootCost(last.size(), 0);
+			for (int i = 1; i <= spurs; ++i)
+			{
+				rootCost[i] = rootCost[i - 1] + edgeCost(last[i - 1], last[i]);
+			}
+			found.assign(spurs, Route());
+			ok.assign(spurs, false);
+
+			// Spur searches [first, end) with one scratch
+			auto run = [&](int first, int end, Scratch& s)
+			{
+				std::vector<int> root;
+				std::vector<int> bannedNext;
+				for (int i = first; i < end; ++i)
+				{
+					root.assign(last.begin(), last.begin() + i + 1);
+					bannedNext.clear();
+					for (auto& a : accepted)
+					{
+						if (a.vertices.size() > root.size() &&
+							std::equal(root.begin(), root.end(), a.vertices.begin()))
+						{
+							bannedNext.push_back(a.vertices[i + 1]);
+						}
+					}
+					ok[i] = spur(s, root, rootCost[i], bannedNext, found[i]);
+				}
+			};
+
+			int workers = std::min(static_cast<int>(m_scratch.size()), spurs);
+			if (m_executor && workers > 1)
+			{
+				std::vector<std::future<void>> done;
+				for (int w = 0; w < workers; ++w)
+				{
+					int first = spurs * w / workers;
+					int end = spurs * (w + 1) / workers;
+					Scratch* s = &m_scratch[w];
+					done.push_back(m_executor->submit([&run, first, end, s]() { run(first, end, *s); }));
+				}
+				for (auto& d : done)
+				{
+					d.get();
+				}
+			}
+			else
+			{
+				run(0, spurs, m_scratch[0]);
+			}
+
+			for (int i = 0; i < spurs; ++i)
+			{
+				if (ok[i] && known.insert(found[i].vertices).second)
+				{
+					candidates.push(std::move(found[i]));
+				}
+			}
+			if (candidates.empty())
+			{
+				break;
+			}
+			accepted.push_back(candidates.top());
+			candidates.pop();
+		}
+		return accepted;
+	}
+};
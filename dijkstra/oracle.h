@@ -0,0 +1,304 @@
+/*
+Approximate distance oracle.
+
+Ranking candidates only needs estimated costs, yet every estimate used to
+be a full ShortestPath::path run.  The oracle precomputes the distances
+from and to k landmark vertices; by the triangle inequality the distance
+d(s, t) then lies within
+	lower = max over L of d(L, t) - d(L, s) and d(s, L) - d(t, L)
+	upper = min over L of d(s, L) + d(L, t)
+and estimate() returns both bounds in O(k): the true cost is always in
+[lower, upper], so a caller can check the width of the interval against
+the error it accepts.  The bounds are exact whenever s or t is a landmark
+or one lies on a shortest route through a landmark.  If t provably cannot
+be reached from s (a landmark reaches s but not t, or t reaches a landmark
+that s does not) reachable is false.  If no landmark lies on a route from
+s to t there is no upper bound and bounded is false; t may still be
+reachable, so an unbounded estimate says nothing about the route.
+
+The graph is directed, so each landmark needs a shortest path tree on the
+graph (from L) and on the reversed graph (to L); the 2k trees are built in
+parallel on an executor.  The distances are stored vertex major, the k
+values of a vertex next to each other, so a query reads four short runs.
+Landmarks are chosen at random, or by farthest point: each next landmark
+is the vertex farthest from those chosen so far, which spreads them over
+the graph and tightens the bounds, but builds the forward trees one after
+the other.
+
+The index is serialised with write() and read(); checksum() is the
+Graph::checksum() of the graph it was built for.
+*/
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "../StaticLib1/random.h"
+#include "dijkstra.h"
+#include "executor.h"
+
+enum class Landmarks
+{
+	Random,
+	Farthest
+};
+
+// Bounds on a distance.  upper is INT_MAX unless bounded; both bounds are
+// INT_MAX if the pair is not reachable.
+struct Estimate
+{
+	int lower;
+	int upper;
+	// False if there is provably no route from s to t
+	bool reachable;
+	// True if a route is known, upper being its cost
+	bool bounded;
+};
+
+// DistanceOracle ADT
+class DistanceOracle
+{
+private:
+	int m_vertices;
+	int m_count;
+	std::uint64_t m_checksum;
+	std::vector<int> m_landmarks;
+	// d(L_i, v) at [v * m_count + i]
+	std::vector<int> m_from;
+	// d(v, L_i) at [v * m_count + i]
+	std::vector<int> m_to;
+
+	DistanceOracle() : m_vertices(0), m_count(0), m_checksum(0) {};
+
+	// Scatter the distances of a tree into landmark column i
+	void store(std::vector<int>& table, int i, const int* distance)
+	{
+		for (int v = 0; v < m_vertices; ++v)
+		{
+			table[static_cast<std::size_t>(v) * m_count + i] = distance[v];
+		}
+	}
+
+	static std::shared_ptr<const Graph> reversed(const Graph& g)
+	{
+		std::vector<Edge> edges;
+		edges.reserve(g.edges());
+		for (int v = 0; v < g.vertices(); ++v)
+		{
+			IdRange ids = g.neighbors(Vertex(v));
+			IdRange costs = g.neighborCosts(Vertex(v));
+			for (int i = 0; i < ids.size(); ++i)
+			{
+				edges.push_back(Edge(ids[i], v, costs[i]));
+			}
+		}
+		auto r = std::make_shared<Graph>(g.vertices(), g.getDensity());
+		r->build(std::move(edges));
+		return r;
+	}
+
+public:
+	// k landmarks (at most the vertex count); the trees are run on ex
+	DistanceOracle(std::shared_ptr<const Graph> g, int k, Executor& ex,
+		Landmarks selection = Landmarks::Farthest, std::uint64_t seed = 1)
+		: m_vertices(g->vertices()), m_count(std::max(0, std::min(k, g->vertices()))), m_checksum(g->checksum())
+	{
+		std::size_t cells = static_cast<std::size_t>(m_vertices) * m_count;
+		m_from.assign(cells, INT_MAX);
+		m_to.assign(cells, INT_MAX);
+		if (m_count == 0)
+		{
+			return;
+		}
+		std::shared_ptr<const Graph> r = reversed(*g);
+		std::vector<std::future<void>> trees;
+		auto toLandmark = [this, r](int i)
+		{
+			return [this, r, i]()
+			{
+				ShortestPath sp(r);
+				sp.tree(Vertex(m_landmarks[i]));
+				store(m_to, i, sp.distances());
+			};
+		};
+
+		// Landmarks actually chosen; farthest point stops early once every
+		// vertex is one.  m_count stays the column stride until the trees
+		// are done.
+		int chosen = m_count;
+		RandomStream rng(seed);
+		if (selection == Landmarks::Random)
+		{
+			// k distinct vertices: the head of a partial shuffle
+			std::vector<int> ids(m_vertices);
+			for (int v = 0; v < m_vertices; ++v)
+			{
+				ids[v] = v;
+			}
+			for (int i = 0; i < m_count; ++i)
+			{
+				std::swap(ids[i], ids[rng.uniform(i, m_vertices - 1)]);
+			}
+			m_landmarks.assign(ids.begin(), ids.begin() + m_count);
+			for (int i = 0; i < m_count; ++i)
+			{
+				trees.push_back(ex.submit([this, g, i]()
+				{
+					ShortestPath sp(g);
+					sp.tree(Vertex(m_landmarks[i]));
+					store(m_from, i, sp.distances());
+				}));
+				trees.push_back(ex.submit(toLandmark(i)));
+			}
+		}
+		else
+		{
+			// Distance from the nearest landmark so far; unreachable
+			// vertices are farthest, so they get a landmark of their own.
+			std::vector<int> nearest(m_vertices, INT_MAX);
+			// No reallocation under the running reverse trees
+			m_landmarks.reserve(m_count);
+			ShortestPath sp(g);
+			int next = rng.uniform(0, m_vertices - 1);
+			for (int i = 0; i < m_count; ++i)
+			{
+				m_landmarks.push_back(next);
+				trees.push_back(ex.submit(toLandmark(i)));
+				sp.tree(Vertex(next));
+				store(m_from, i, sp.distances());
+				const int* distance = sp.distances();
+				int farthest = -1;
+				for (int v = 0; v < m_vertices; ++v)
+				{
+					nearest[v] = std::min(nearest[v], distance[v]);
+					if (nearest[v] != 0 && (farthest < 0 || nearest[v] > nearest[farthest]))
+					{
+						farthest = v;
+					}
+				}
+				if (farthest < 0)
+				{
+					// Every vertex is a landmark
+					chosen = i + 1;
+					break;
+				}
+				next = farthest;
+			}
+		}
+		for (auto& t : trees)
+		{
+			t.get();
+		}
+		if (chosen < m_count)
+		{
+			// Close up the unused columns
+			std::vector<int> from(static_cast<std::size_t>(m_vertices) * chosen);
+			std::vector<int> to(from.size());
+			for (int v = 0; v < m_vertices; ++v)
+			{
+				std::copy_n(&m_from[static_cast<std::size_t>(v) * m_count], chosen, &from[static_cast<std::size_t>(v) * chosen]);
+				std::copy_n(&m_to[static_cast<std::size_t>(v) * m_count], chosen, &to[static_cast<std::size_t>(v) * chosen]);
+			}
+			m_from.swap(from);
+			m_to.swap(to);
+			m_count = chosen;
+		}
+	}
+
+	int vertices() const { return m_vertices; };
+	int landmarks() const { return m_count; };
+	int landmark(int i) const { return m_landmarks[i]; };
+	std::uint64_t checksum() const { return m_checksum; };
+	// Heap bytes of the index
+	std::size_t memoryBytes() const
+	{
+		return (m_from.capacity() + m_to.capacity() + m_landmarks.capacity()) * sizeof(int);
+	}
+
+	Estimate estimate(int s, int t) const
+	{
+		if (s == t)
+		{
+			return Estimate{ 0, 0, true, true };
+		}
+		const int* fromS = m_from.data() + static_cast<std::size_t>(s) * m_count;
+		const int* fromT = m_from.data() + static_cast<std::size_t>(t) * m_count;
+		const int* toS = m_to.data() + static_cast<std::size_t>(s) * m_count;
+		const int* toT = m_to.data() + static_cast<std::size_t>(t) * m_count;
+		long long lower = 0;
+		long long upper = LLONG_MAX;
+		for (int i = 0; i < m_count; ++i)
+		{
+			if (fromS[i] != INT_MAX)
+			{
+				if (fromT[i] == INT_MAX)
+				{
+					// L reaches s but not t, so s does not reach t
+					return Estimate{ INT_MAX, INT_MAX, false, false };
+				}
+				lower = std::max(lower, static_cast<long long>(fromT[i]) - fromS[i]);
+			}
+			if (toT[i] != INT_MAX)
+			{
+				if (toS[i] == INT_MAX)
+				{
+					// t reaches L but s does not, so s does not reach t
+					return Estimate{ INT_MAX, INT_MAX, false, false };
+				}
+				lower = std::max(lower, static_cast<long long>(toS[i]) - toT[i]);
+			}
+			if (toS[i] != INT_MAX && fromT[i] != INT_MAX)
+			{
+				upper = std::min(upper, static_cast<long long>(toS[i]) + fromT[i]);
+			}
+		}
+		bool bounded = upper < INT_MAX;
+		return Estimate{ static_cast<int>(lower), bounded ? static_cast<int>(upper) : INT_MAX, true, bounded };
+	}
+
+	// "ORCL", int32 vertices, int32 landmarks, uint64 checksum, then the
+	// landmarks and the two tables as int32, native byte order
+	void write(std::ostream& out) const
+	{
+		std::int32_t header[2] = { m_vertices, m_count };
+		out.write("ORCL", 4);
+		out.write(reinterpret_cast<const char*>(header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(&m_checksum), sizeof(m_checksum));
+		out.write(reinterpret_cast<const char*>(m_landmarks.data()), m_landmarks.size() * sizeof(int));
+		out.write(reinterpret_cast<const char*>(m_from.data()), m_from.size() * sizeof(int));
+		out.write(reinterpret_cast<const char*>(m_to.data()), m_to.size() * sizeof(int));
+	}
+
+	// Null if in does not hold a whole oracle
+	static std::unique_ptr<DistanceOracle> read(std::istream& in)
+	{
+		char magic[4];
+		std::int32_t header[2];
+		std::unique_ptr<DistanceOracle> o(new DistanceOracle);
+		if (!in.read(magic, 4) || std::memcmp(magic, "ORCL", 4) != 0 ||
+			!in.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+			!in.read(reinterpret_cast<char*>(&o->m_checksum), sizeof(o->m_checksum)) ||
+			header[0] < 0 || header[1] < 0 || header[1] > header[0])
+		{
+			return nullptr;
+		}
+		o->m_vertices = header[0];
+		o->m_count = header[1];
+		std::size_t cells = static_cast<std::size_t>(o->m_vertices) * o->m_count;
+		o->m_landmarks.resize(o->m_count);
+		o->m_from.resize(cells);
+		o->m_to.resize(cells);
+		if (!in.read(reinterpret_cast<char*>(o->m_landmarks.data()), o->m_landmarks.size() * sizeof(int)) ||
+			!in.read(reinterpret_cast<char*>(o->m_from.data()), cells * sizeof(int)) ||
+			!in.read(reinterpret_cast<char*>(o->m_to.data()), cells * sizeof(int)))
+		{
+			return nullptr;
+		}
+		return o;
+	}
+};
@@ -0,0 +1,210 @@
+/*
+Shortest path result cache.
+
+Query traffic is skewed: the same (src, dst) pairs are asked for over and
+over.  PathCache keeps the result of recent queries keyed on
+(src, dst, graph version).  Every modification of a graph gives it a new,
+process wide unique version (nextGraphVersion()), so a result computed on
+an older graph can never be returned; the stale entries simply age out of
+the LRU, or can be dropped eagerly with purge().
+
+The cache is split into shards, each with its own lock and LRU list, so
+concurrent solvers mostly contend on different locks.
+*/
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "../StaticLib1/footprint.h"
+
+// Unique version for a new or modified graph
+inline unsigned long long nextGraphVersion()
+{
+	static std::atomic<unsigned long long> version{ 0 };
+	return ++version;
+}
+
+// A cached query result.  route is empty if the route was not requested.
+struct CachedPath
+{
+	int cost;
+	std::vector<int> route;
+};
+
+class PathCache
+{
+public:
+	struct Metrics
+	{
+		unsigned long long hits = 0;
+		unsigned long long misses = 0;
+		unsigned long long evictions = 0;
+		std::size_t entries = 0;
+		std::size_t bytes = 0;
+
+		double hitRate() const
+		{
+			unsigned long long total = hits + misses;
+			return total ? static_cast<double>(hits) / total : 0.0;
+		}
+	};
+
+private:
+	struct Key
+	{
+		int src;
+		int dst;
+		unsigned long long version;
+
+		bool operator==(const Key& k) const
+		{
+			return src == k.src && dst == k.dst && version == k.version;
+		}
+	};
+
+	struct KeyHash
+	{
+		std::size_t operator()(const Key& k) const
+		{
+			unsigned long long h = k.version * 0x9E3779B97F4A7C15ull;
+			h ^= (static_cast<unsigned long long>(static_cast<unsigned>(k.src)) << 32) |
+				static_cast<unsigned>(k.dst);
+			h *= 0xBF58476D1CE4E5B9ull;
+			return static_cast<std::size_t>(h ^ (h >> 31));
+		}
+	};
+
+	using Entry = std::pair<Key, CachedPath>;
+	// List and hash nodes are charged to the Cache component (footprint.h)
+	using Lru = std::list<Entry, footprint::Allocator<Entry, footprint::Component::Cache>>;
+	using Index = std::unordered_map<Key, Lru::iterator, KeyHash, std::equal_to<Key>,
+		footprint::Allocator<std::pair<const Key, Lru::iterator>, footprint::Component::Cache>>;
+
+	struct Shard
+	{
+		std::mutex lock;
+		// Most recently used at the front
+		Lru lru;
+		Index index;
+		Metrics metrics;
+	};
+
+	std::vector<std::unique_ptr<Shard>> m_shards;
+	std::size_t m_shardCapacity;
+
+	Shard& shard(const Key& k) const
+	{
+		return *m_shards[KeyHash()(k) % m_shards.size()];
+	}
+
+	// Approximate heap footprint of one entry: list node, hash node and
+	// the route.
+	static std::size_t entryBytes(const CachedPath& p)
+	{
+		return sizeof(Entry) + 2 * sizeof(void*) +
+			sizeof(Key) + 3 * sizeof(void*) +
+			p.route.capacity() * sizeof(int);
+	}
+
+	void erase(Shard& s, Lru::iterator it)
+	{
+		s.metrics.bytes -= entryBytes(it->second);
+		s.index.erase(it->first);
+		s.lru.erase(it);
+		--s.metrics.entries;
+	}
+
+public:
+	// capacity is the total number of entries over all shards; shards is
+	// clamped to at least one
+	explicit PathCache(std::size_t capacity = 4096, int shards = 16)
+		: m_shardCapacity(std::max<std::size_t>(capacity / std::max(shards, 1), 1))
+	{
+		for (int i = 0; i < std::max(shards, 1); ++i)
+		{
+			m_shards.emplace_back(new Shard);
+		}
+	}
+
+	// With withRoute an entry stored without its route cannot answer the
+	// query and counts as a miss; an unreachable pair has no route to store.
+	bool lookup(int src, int dst, unsigned long long version, CachedPath& result, bool withRoute = false)
+	{
+		Key k{ src, dst, version };
+		Shard& s = shard(k);
+		std::lock_guard<std::mutex> guard(s.lock);
+		auto it = s.index.find(k);
+		if (it == s.index.end() ||
+			(withRoute && it->second->second.cost != INT_MAX && it->second->second.route.empty()))
+		{
+			++s.metrics.misses;
+			return false;
+		}
+		++s.metrics.hits;
+		s.lru.splice(s.lru.begin(), s.lru, it->second);
+		result = it->second->second;
+		return true;
+	}
+
+	void store(int src, int dst, unsigned long long version, CachedPath result)
+	{
+		Key k{ src, dst, version };
+		Shard& s = shard(k);
+		std::lock_guard<std::mutex> guard(s.lock);
+		auto it = s.index.find(k);
+		if (it != s.index.end())
+		{
+			erase(s, it->second);
+		}
+		s.lru.emplace_front(k, std::move(result));
+		s.index[k] = s.lru.begin();
+		s.metrics.bytes += entryBytes(s.lru.front().second);
+		++s.metrics.entries;
+		while (s.metrics.entries > m_shardCapacity)
+		{
+			erase(s, std::prev(s.lru.end()));
+			++s.metrics.evictions;
+		}
+	}
+
+	// Drop every entry computed on the given (now stale) graph version
+	void purge(unsigned long long version)
+	{
+		for (auto& s : m_shards)
+		{
+			std::lock_guard<std::mutex> guard(s->lock);
+			for (auto it = s->lru.begin(); it != s->lru.end();)
+			{
+				auto next = std::next(it);
+				if (it->first.version == version)
+				{
+					erase(*s, it);
+				}
+				it = next;
+			}
+		}
+	}
+
+	Metrics metrics() const
+	{
+		Metrics total;
+		for (auto& s : m_shards)
+		{
+			std::lock_guard<std::mutex> guard(s->lock);
+			total.hits += s->metrics.hits;
+			total.misses += s->metrics.misses;
+			total.evictions += s->metrics.evictions;
+			total.entries += s->metrics.entries;
+			total.bytes += s->metrics.bytes;
+		}
+		return total;
+	}
+};
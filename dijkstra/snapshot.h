@@ -0,0 +1,218 @@
+/*
+Versioned graph for concurrent readers and writers.
+
+A Graph is immutable once shared, so solvers never see it change under
+them; the question is how to move readers to a modified graph.
+VersionedGraph holds the current snapshot:
+	writers - apply a batch of edge changes (Graph::withChanges) to a
+	          private copy of the current snapshot and publish the copy
+	          with one atomic pointer swap; writers are serialised, so
+	          no change is lost
+	readers - pin() the current snapshot and run any number of queries
+	          on it; a pin is two atomic operations on the reader's own
+	          slot, never waits for a writer and never sees a half made
+	          graph.  Queries started later get the newer snapshot.
+
+Replaced snapshots are reclaimed by epochs rather than by shared_ptr
+counts, which would make every reader write the one shared count.  The
+global epoch goes up on each publish; a reader records the epoch it saw
+in its slot while pinned.  A snapshot retired at epoch E was unlinked
+before the epoch moved past E, so once no slot holds an epoch <= E no
+reader can still be using it and the writer deletes it.  A reader that
+stays pinned only delays the reclamation of the snapshots it may see.
+
+	VersionedGraph vg(std::move(g));
+	{
+		VersionedGraph::Snapshot s = vg.pin();
+		ShortestPath sp(s.shared());
+		sp.path(Vertex(0), Vertex(5));
+	}
+	vg.update({ Edge(0, 5, 1) });
+*/
+#pragma once
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "dijkstra.h"
+
+// VersionedGraph ADT
+class VersionedGraph
+{
+private:
+	// Epoch of the snapshot a reader has pinned, 0 when idle; one cache
+	// line each so readers do not share lines.
+	struct alignas(64) Slot
+	{
+		std::atomic<unsigned long long> epoch{ 0 };
+		std::atomic<bool> used{ false };
+	};
+
+	// A snapshot and the number of publishes before it, read together
+	struct Node
+	{
+		Graph graph;
+		unsigned long long version;
+	};
+
+	std::atomic<const Node*> m_current;
+	std::atomic<unsigned long long> m_epoch;
+	std::unique_ptr<Slot[]> m_slots;
+	int m_slotCount;
+	// Serialises the writers and guards m_retired
+	std::mutex m_writer;
+	// Replaced snapshots and the epoch they were retired at
+	std::vector<std::pair<unsigned long long, const Node*>> m_retired;
+
+	Slot& acquire()
+	{
+		// Start from a slot picked by thread, so readers mostly land on
+		// different slots at the first try
+		std::size_t start = std::hash<std::thread::id>()(std::this_thread::get_id());
+		for (;;)
+		{
+			for (int i = 0; i < m_slotCount; ++i)
+			{
+				Slot& s = m_slots[(start + i) % m_slotCount];
+				bool idle = false;
+				if (!s.used.load(std::memory_order_relaxed) && s.used.compare_exchange_strong(idle, true))
+				{
+					return s;
+				}
+			}
+			// More readers pinned than slots
+			std::this_thread::yield();
+		}
+	}
+
+	// Delete the retired snapshots no pinned reader can see; m_writer held
+	void reclaim()
+	{
+		unsigned long long oldest = ULLONG_MAX;
+		for (int i = 0; i < m_slotCount; ++i)
+		{
+			unsigned long long e = m_slots[i].epoch.load();
+			if (e != 0 && e < oldest)
+			{
+				oldest = e;
+			}
+		}
+		auto kept = m_retired.begin();
+		for (auto& r : m_retired)
+		{
+			if (r.first < oldest)
+			{
+				delete r.second;
+			}
+			else
+			{
+				*kept++ = r;
+			}
+		}
+		m_retired.erase(kept, m_retired.end());
+	}
+
+	// Swap in graph; m_writer held
+	void replace(Graph graph)
+	{
+		const Node* old = m_current.load();
+		const Node* next = new Node{ std::move(graph), old->version + 1 };
+		m_current.store(next);
+		m_retired.emplace_back(m_epoch.fetch_add(1), old);
+		reclaim();
+	}
+
+public:
+	// A pinned snapshot: valid, and unchanged, until it is destroyed
+	class Snapshot
+	{
+	private:
+		Slot* m_slot;
+		const Graph* m_graph;
+		unsigned long long m_version;
+
+	public:
+		Snapshot(Slot* slot, const Node* node)
+			: m_slot(slot), m_graph(&node->graph), m_version(node->version)
+		{};
+		~Snapshot()
+		{
+			if (m_slot)
+			{
+				m_slot->epoch.store(0, std::memory_order_release);
+				m_slot->used.store(false, std::memory_order_release);
+			}
+		}
+		Snapshot(Snapshot&& other) : m_slot(other.m_slot), m_graph(other.m_graph), m_version(other.m_version)
+		{
+			other.m_slot = nullptr;
+		};
+		Snapshot(const Snapshot&) = delete;
+		Snapshot& operator=(const Snapshot&) = delete;
+		Snapshot& operator=(Snapshot&&) = delete;
+
+		const Graph& graph() const { return *m_graph; };
+		const Graph* operator->() const { return m_graph; };
+		// Non-owning pointer for ShortestPath; only valid while pinned
+		std::shared_ptr<const Graph> shared() const { return std::shared_ptr<const Graph>(std::shared_ptr<const Graph>(), m_graph); };
+		// Number of publishes before this snapshot, 0 for the first graph
+		unsigned long long version() const { return m_version; };
+	};
+
+	// readers is the number of slots, the pins that can be held at once
+	explicit VersionedGraph(Graph g, int readers = 128)
+		: m_current(new Node{ std::move(g), 0 }), m_epoch(1),
+		m_slots(new Slot[readers > 0 ? readers : 1]), m_slotCount(readers > 0 ? readers : 1)
+	{};
+	// No snapshot may be pinned any more
+	~VersionedGraph()
+	{
+		delete m_current.load();
+		for (auto& r : m_retired)
+		{
+			delete r.second;
+		}
+	}
+	VersionedGraph(const VersionedGraph&) = delete;
+	VersionedGraph& operator=(const VersionedGraph&) = delete;
+
+	Snapshot pin()
+	{
+		Slot& s = acquire();
+		// The epoch is recorded before the snapshot is read, both
+		// sequentially consistent: a writer that found this slot idle
+		// published before the read below, so the snapshot read is never
+		// one it has deleted.
+		s.epoch.store(m_epoch.load());
+		return Snapshot(&s, m_current.load());
+	}
+
+	// Publish g as the next snapshot
+	void publish(Graph g)
+	{
+		std::lock_guard<std::mutex> guard(m_writer);
+		replace(std::move(g));
+	}
+
+	// Apply a batch of edge changes (see Graph::withChanges) to the current
+	// snapshot and publish the result
+	void update(std::vector<Edge> changes)
+	{
+		std::lock_guard<std::mutex> guard(m_writer);
+		replace(m_current.load()->graph.withChanges(std::move(changes)));
+	}
+
+	// Replaced snapshots still waiting for their readers
+	std::size_t retired()
+	{
+		std::lock_guard<std::mutex> guard(m_writer);
+		reclaim();
+		return m_retired.size();
+	}
+};
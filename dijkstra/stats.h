@@ -0,0 +1,126 @@
+/*
+Hot path counters for the shortest path and spanning tree solvers.
+
+The counters are compiled in only when GRAPH_STATS is defined (add it to
+the preprocessor definitions of the project).  Otherwise STATS_ADD expands
+to nothing and the solvers are exactly as fast as before; stats() then
+always reports zeros.
+
+Each solver counts into its own SolverStats during a run.  At the end of a
+run the counts are added to a thread local total - no atomics or locks on
+the hot path.  A thread's total is merged into the process wide total when
+the thread exits or calls flushThreadStats().
+*/
+#pragma once
+#include <iostream>
+#include <mutex>
+
+#ifdef GRAPH_STATS
+#define STATS_ADD(stats, field, n) ((stats).field += (n))
+#else
+#define STATS_ADD(stats, field, n) ((void)0)
+#endif
+
+struct SolverStats
+{
+	unsigned long long runs = 0;
+	unsigned long long verticesSettled = 0;
+	unsigned long long edgesScanned = 0;
+	unsigned long long relaxations = 0;
+	unsigned long long queuePushes = 0;
+	unsigned long long queuePops = 0;
+	unsigned long long decreaseKeys = 0;
+	// Estimate of the graph and solver array bytes read or written
+	unsigned long long bytesTouched = 0;
+
+	SolverStats& operator+=(const SolverStats& s)
+	{
+		runs += s.runs;
+		verticesSettled += s.verticesSettled;
+		edgesScanned += s.edgesScanned;
+		relaxations += s.relaxations;
+		queuePushes += s.queuePushes;
+		queuePops += s.queuePops;
+		decreaseKeys += s.decreaseKeys;
+		bytesTouched += s.bytesTouched;
+		return *this;
+	}
+
+	friend std::ostream& operator<<(std::ostream& out, const SolverStats& s)
+	{
+		out << "runs: " << s.runs;
+		out << ", settled: " << s.verticesSettled;
+		out << ", edges scanned: " << s.edgesScanned;
+		out << ", relaxations: " << s.relaxations;
+		out << ", pushes: " << s.queuePushes;
+		out << ", pops: " << s.queuePops;
+		out << ", decrease keys: " << s.decreaseKeys;
+		out << ", bytes touched: " << s.bytesTouched;
+		return out;
+	}
+};
+
+// Process wide total, only touched when a thread flushes.
+inline SolverStats& globalStats(std::mutex*& lock)
+{
+	static std::mutex mutex;
+	static SolverStats total;
+	lock = &mutex;
+	return total;
+}
+
+// Thread local total; merged into the global one on thread exit.
+class ThreadStats
+{
+private:
+	SolverStats m_total;
+public:
+	~ThreadStats() { flush(); };
+	SolverStats& total() { return m_total; };
+	void flush()
+	{
+		std::mutex* lock;
+		SolverStats& global = globalStats(lock);
+		std::lock_guard<std::mutex> guard(*lock);
+		global += m_total;
+		m_total = SolverStats();
+	}
+};
+
+inline ThreadStats& threadStats()
+{
+	static thread_local ThreadStats stats;
+	return stats;
+}
+
+// Called by the solvers at the end of a run
+inline void recordStats(const SolverStats& s)
+{
+#ifdef GRAPH_STATS
+	threadStats().total() += s;
+#else
+	(void)s;
+#endif
+}
+
+// Totals of the calling thread since its last flush
+inline SolverStats currentThreadStats()
+{
+	return threadStats().total();
+}
+
+inline void flushThreadStats()
+{
+	threadStats().flush();
+}
+
+// Everything flushed so far plus the calling thread's own counts
+inline SolverStats processStats()
+{
+	std::mutex* lock;
+	SolverStats& global = globalStats(lock);
+	std::lock_guard<std::mutex> guard(*lock);
+	SolverStats total = global;
+	total += threadStats().total();
+	return total;
+}
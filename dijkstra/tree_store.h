@@ -0,0 +1,187 @@
+/*
+Persisted shortest path trees.
+
+ShortestPath keeps nothing past the process, so a restarted service has
+to recompute every result before the hot queries are fast again.  A
+TreeStore saves the whole shortest path tree of a source (the distance
+and predecessor of every vertex) to a file, and finds it again in a
+later process by graph checksum (Graph::checksum()) and source.
+
+The files are memory mapped (mapped_file.h) the first time a source is
+asked for, and their pages are read as queries touch them, so a restart
+answers stored sources at once without reading the store up front.
+A file saved for another graph, truncated or of an older layout is
+ignored; the source is then simply computed again.
+
+File <dir>/<checksum, 16 hex digits>-<source>.spt, native byte order:
+	header     - "SPTR", uint32 format, uint64 checksum, int32 source,
+	             int32 vertices
+	distance   - int32 per vertex, INT_MAX if unreachable
+	previous   - int32 per vertex, the source for itself; any value
+	             for an unreachable vertex
+A tree is written to a temporary file and renamed into place, so a
+reader never maps a half written tree.
+*/
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../StaticLib1/mapped_file.h"
+#include "dijkstra.h"
+
+// StoredTree ADT
+// A mapped tree file; the arrays point into the mapping.
+class StoredTree
+{
+public:
+	struct Header
+	{
+		char magic[4];
+		std::uint32_t format;
+		std::uint64_t checksum;
+		std::int32_t source;
+		std::int32_t vertices;
+	};
+	static const std::uint32_t currentFormat = 1;
+
+private:
+	MappedFile m_file;
+	const Header* m_header;
+	const std::int32_t* m_distance;
+	const std::int32_t* m_previous;
+
+	StoredTree(MappedFile file)
+		: m_file(std::move(file)), m_header(static_cast<const Header*>(m_file.data()))
+	{
+		m_distance = reinterpret_cast<const std::int32_t*>(m_header + 1);
+		m_previous = m_distance + m_header->vertices;
+	};
+
+public:
+	// Map the tree file, null if it is missing or not a tree of source on
+	// a graph with this checksum and vertex count.
+	static std::shared_ptr<const StoredTree> open(const std::string& path, std::uint64_t checksum, int source, int vertices)
+	{
+		MappedFile file(path);
+		if (file.size() < sizeof(Header))
+		{
+			return nullptr;
+		}
+		const Header* h = static_cast<const Header*>(file.data());
+		if (std::memcmp(h->magic, "SPTR", 4) != 0 || h->format != currentFormat ||
+			h->checksum != checksum || h->source != source || h->vertices != vertices ||
+			file.size() != sizeof(Header) + 2 * static_cast<std::size_t>(vertices) * sizeof(std::int32_t))
+		{
+			return nullptr;
+		}
+		return std::shared_ptr<const StoredTree>(new StoredTree(std::move(file)));
+	}
+
+	int source() const { return m_header->source; };
+	int vertices() const { return m_header->vertices; };
+	// INT_MAX if v cannot be reached
+	int distance(int v) const { return m_distance[v]; };
+	int previous(int v) const { return m_previous[v]; };
+	// Vertices from the source to dst, empty if dst cannot be reached
+	std::vector<int> route(int dst) const
+	{
+		std::vector<int> vertices;
+		if (m_distance[dst] == INT_MAX)
+		{
+			return vertices;
+		}
+		for (int v = dst; v != source(); v = m_previous[v])
+		{
+			vertices.push_back(v);
+		}
+		vertices.push_back(source());
+		std::reverse(vertices.begin(), vertices.end());
+		return vertices;
+	}
+};
+
+// TreeStore ADT
+// The stored trees of one graph.  find() is safe to call from any number
+// of threads; a mapped tree stays valid while any caller holds it.
+class TreeStore
+{
+private:
+	std::string m_dir;
+	std::uint64_t m_checksum;
+	int m_vertices;
+	std::mutex m_lock;
+	// Every source looked up so far; null if it has no valid file
+	std::unordered_map<int, std::shared_ptr<const StoredTree>> m_trees;
+
+public:
+	TreeStore(std::string dir, const Graph& g)
+		: m_dir(std::move(dir)), m_checksum(g.checksum()), m_vertices(g.vertices())
+	{};
+
+	std::uint64_t checksum() const { return m_checksum; };
+
+	std::string fileName(int src) const
+	{
+		char name[40];
+		std::snprintf(name, sizeof(name), "%016llx-%d.spt", static_cast<unsigned long long>(m_checksum), src);
+		return m_dir.empty() ? name : m_dir + "/" + name;
+	}
+
+	// Tree of src, mapped on the first call; null if it was never saved
+	std::shared_ptr<const StoredTree> find(int src)
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		auto it = m_trees.find(src);
+		if (it == m_trees.end())
+		{
+			it = m_trees.emplace(src, StoredTree::open(fileName(src), m_checksum, src, m_vertices)).first;
+		}
+		return it->second;
+	}
+
+	// Compute the tree of src with sp, which must be a solver over the
+	// store's graph, and save it; false if the file cannot be written.
+	bool save(ShortestPath& sp, int src)
+	{
+		sp.tree(Vertex(src));
+		StoredTree::Header h;
+		std::memcpy(h.magic, "SPTR", 4);
+		h.format = StoredTree::currentFormat;
+		h.checksum = m_checksum;
+		h.source = src;
+		h.vertices = m_vertices;
+
+		std::string name = fileName(src);
+		std::string temp = name + ".tmp";
+		{
+			std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+			out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+			out.write(reinterpret_cast<const char*>(sp.distances()), m_vertices * sizeof(std::int32_t));
+			out.write(reinterpret_cast<const char*>(sp.predecessors()), m_vertices * sizeof(std::int32_t));
+			if (!out.flush())
+			{
+				std::remove(temp.c_str());
+				return false;
+			}
+		}
+		// rename() does not replace an existing file on Windows
+		std::remove(name.c_str());
+		if (std::rename(temp.c_str(), name.c_str()) != 0)
+		{
+			std::remove(temp.c_str());
+			return false;
+		}
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_trees.erase(src);
+		return true;
+	}
+};
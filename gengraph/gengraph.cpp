@@ -0,0 +1,157 @@
+// Need the following as the first include for a Visual Studio environment
+#include "stdafx.h"
+
+/*
+Synthetic graph generator for the scaling benchmarks.
+
+Streams a grid, random geometric, R-MAT or Barabasi-Albert graph
+(generators.h) straight to a file in the Sparse format read by mst,
+loadgen and shardsp, or in the Binary format; the edges are never held
+in memory, so graphs of 10^8 edges only need O(V) memory.  Prints the
+vertex and edge counts, the out degree distribution and the time taken.
+*/
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "../StaticLib1/generators.h"
+#include "../StaticLib1/graph_io.h"
+#include "../StaticLib1/random.h"
+#include "../StaticLib1/timer.h"
+
+// Usage: gengraph grid rows [cols] [options]
+//        gengraph geometric vertices [degree] [options]
+//        gengraph rmat scale [edgefactor] [options]
+//        gengraph ba vertices [m] [options]
+// options: [--seed n] [--output sparse|binary|none] [--out file]
+// cols defaults to rows, degree to 8, edgefactor to 16 (Graph500) and m
+// to 4.  The graph goes to --out, or standard output (switched to binary
+// mode for the Binary format); --output none only reports the statistics.
+int main(int argc, char **argv)
+{
+	if (argc < 3)
+	{
+		std::cerr << "Usage: gengraph grid|geometric|rmat|ba size [param] [--seed n] [--output sparse|binary|none] [--out file]\n";
+		return 1;
+	}
+	std::string kind = argv[1];
+	int size = std::max(1, std::atoi(argv[2]));
+	int a = 3;
+	double param = 0.0;
+	if (a < argc && argv[a][0] != '-')
+	{
+		param = std::atof(argv[a++]);
+	}
+	std::uint64_t seed{ 1 };
+	OutputFormat format{ OutputFormat::Sparse };
+	std::string fname;
+	for (; a < argc; ++a)
+	{
+		std::string arg = argv[a];
+		if (arg == "--seed" && a + 1 < argc)
+		{
+			seed = std::strtoull(argv[++a], nullptr, 10);
+		}
+		else if (arg == "--output" && a + 1 < argc)
+		{
+			format = parseOutputFormat(argv[++a]);
+		}
+		else if (arg == "--out" && a + 1 < argc)
+		{
+			fname = argv[++a];
+		}
+	}
+	if (format == OutputFormat::Matrix)
+	{
+		std::cerr << "gengraph: the matrix format is not supported, use sparse or binary\n";
+		return 1;
+	}
+
+	long long vertices = 0;
+	if (kind == "grid")
+	{
+		vertices = generators::gridVertices(size, param > 0 ? static_cast<int>(param) : size);
+	}
+	else if (kind == "rmat")
+	{
+		size = std::min(size, 30);
+		vertices = generators::rmatVertices(size);
+	}
+	else if (kind == "geometric" || kind == "ba")
+	{
+		vertices = size;
+	}
+	else
+	{
+		std::cerr << "gengraph: unknown graph kind " << kind << '\n';
+		return 1;
+	}
+
+	std::ofstream file;
+	if (!fname.empty())
+	{
+		file.open(fname, format == OutputFormat::Binary ? std::ios::binary : std::ios::out);
+		if (!file)
+		{
+			std::cerr << "gengraph: cannot write " << fname << '\n';
+			return 1;
+		}
+	}
+#ifdef _WIN32
+	else if (format == OutputFormat::Binary)
+	{
+		// A text mode stdout would turn every 0x0A byte into CR LF
+		_setmode(_fileno(stdout), _O_BINARY);
+	}
+#endif
+	std::ostream& out = fname.empty() ? std::cout : file;
+
+	Timer t;
+	std::vector<int> degree(static_cast<std::size_t>(vertices), 0);
+	EdgeWriter writer(out, vertices, format);
+	auto sink = [&](int src, int dst, int cost)
+	{
+		++degree[src];
+		writer(src, dst, cost);
+	};
+	RandomStream rng(seed);
+	if (kind == "grid")
+	{
+		generators::grid(size, param > 0 ? static_cast<int>(param) : size, rng, sink);
+	}
+	else if (kind == "geometric")
+	{
+		generators::geometric(size, param > 0 ? param : 8.0, rng, sink);
+	}
+	else if (kind == "rmat")
+	{
+		generators::rmat(size, param > 0 ? static_cast<int>(param) : 16, rng, sink);
+	}
+	else
+	{
+		generators::barabasiAlbert(size, param > 0 ? static_cast<int>(param) : 4, rng, sink);
+	}
+	writer.flush();
+	double seconds = t.elapsed();
+
+	// Statistics go to stderr when the graph goes to stdout
+	std::ostream& report = fname.empty() && format != OutputFormat::None ? std::cerr : std::cout;
+	long long edges = writer.edges();
+	std::sort(degree.begin(), degree.end());
+	int p99 = degree.empty() ? 0 : degree[static_cast<std::size_t>((degree.size() - 1) * 0.99)];
+	report << kind << ": " << vertices << " vertices, " << edges << " edges\n";
+	report << "out degree: mean " << std::fixed << std::setprecision(2);
+	report << (vertices > 0 ? static_cast<double>(edges) / vertices : 0.0);
+	report << ", p99 " << p99 << ", max " << (degree.empty() ? 0 : degree.back()) << '\n';
+	report << "time: " << std::setprecision(3) << seconds << " s\n";
+	return 0;
+}
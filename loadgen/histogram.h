@@ -0,0 +1,185 @@
+/*
+Latency histogram in the style of HdrHistogram.
+
+Values (nanoseconds) are counted in log-linear buckets: every power of 2
+range is split into 128 equal sub-buckets, so any recorded value is
+reported to within 1/128 (under 1%) whatever its magnitude, from 1ns to
+centuries, in a fixed 60KB of counts.  Recording is an index computation
+and an increment.  Histograms of several threads are combined with
+merge().
+*/
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+// LatencyHistogram ADT
+class LatencyHistogram
+{
+private:
+	// Sub-buckets per power of 2 is 2^subBits, of which the upper half is
+	// used above the first power of 2 range.
+	static const int subBits = 8;
+	static const int subCount = 1 << subBits;
+	static const int halfCount = subCount / 2;
+	static const int bucketCount = 64 - subBits + 1;
+
+	std::vector<std::uint64_t> m_counts;
+	std::uint64_t m_total;
+	std::uint64_t m_min;
+	std::uint64_t m_max;
+	double m_sum;
+	double m_sumSquares;
+
+	static int highestBit(std::uint64_t v)
+	{
+		int bit = 0;
+		while (v >>= 1)
+		{
+			++bit;
+		}
+		return bit;
+	}
+
+	static std::size_t indexOf(std::uint64_t v)
+	{
+		if (v < static_cast<std::uint64_t>(subCount))
+		{
+			return static_cast<std::size_t>(v);
+		}
+		int bucket = highestBit(v) - subBits + 1;
+		std::uint64_t sub = v >> bucket;
+		return subCount + static_cast<std::size_t>(bucket - 1) * halfCount + static_cast<std::size_t>(sub - halfCount);
+	}
+
+	// Largest value counted at index i
+	static std::uint64_t highestAt(std::size_t i)
+	{
+		if (i < static_cast<std::size_t>(subCount))
+		{
+			return i;
+		}
+		int bucket = static_cast<int>((i - subCount) / halfCount) + 1;
+		std::uint64_t sub = (i - subCount) % halfCount + halfCount;
+		return (sub << bucket) + ((1ull << bucket) - 1);
+	}
+
+public:
+	LatencyHistogram()
+		: m_counts(subCount + (bucketCount - 1) * halfCount, 0), m_total(0),
+		m_min(UINT64_MAX), m_max(0), m_sum(0), m_sumSquares(0) {};
+
+	void record(std::uint64_t value)
+	{
+		++m_counts[indexOf(value)];
+		++m_total;
+		m_min = std::min(m_min, value);
+		m_max = std::max(m_max, value);
+		m_sum += static_cast<double>(value);
+		m_sumSquares += static_cast<double>(value) * value;
+	}
+
+	void merge(const LatencyHistogram& h)
+	{
+		for (std::size_t i = 0; i < m_counts.size(); ++i)
+		{
+			m_counts[i] += h.m_counts[i];
+		}
+		m_total += h.m_total;
+		m_min = std::min(m_min, h.m_min);
+		m_max = std::max(m_max, h.m_max);
+		m_sum += h.m_sum;
+		m_sumSquares += h.m_sumSquares;
+	}
+
+	std::uint64_t count() const { return m_total; };
+	std::uint64_t min() const { return m_total ? m_min : 0; };
+	std::uint64_t max() const { return m_max; };
+	double mean() const { return m_total ? m_sum / m_total : 0.0; };
+	double stddev() const
+	{
+		if (!m_total)
+		{
+			return 0.0;
+		}
+		double m = mean();
+		return std::sqrt(std::max(0.0, m_sumSquares / m_total - m * m));
+	}
+
+	// Smallest recorded value v (to the histogram's precision) with at
+	// least percentile % of the values <= v
+	std::uint64_t percentile(double percentile) const
+	{
+		if (!m_total)
+		{
+			return 0;
+		}
+		double wanted = std::ceil(percentile / 100.0 * m_total);
+		std::uint64_t target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(wanted));
+		std::uint64_t seen = 0;
+		for (std::size_t i = 0; i < m_counts.size(); ++i)
+		{
+			seen += m_counts[i];
+			if (seen >= target)
+			{
+				return std::min(highestAt(i), m_max);
+			}
+		}
+		return m_max;
+	}
+
+	// HdrHistogram percentile distribution: percentiles closing in on
+	// 100% by halves, ticksPerHalf lines per halving, values divided by
+	// scale (1000 gives microseconds).
+	void writeDistribution(std::ostream& out, double scale = 1000.0, int ticksPerHalf = 5) const
+	{
+		std::ios::fmtflags flags = out.flags();
+		std::streamsize precision = out.precision();
+		out << std::fixed;
+		out << std::setw(12) << "Value" << " " << std::setw(14) << "Percentile";
+		out << " " << std::setw(10) << "TotalCount" << " " << std::setw(14) << "1/(1-Percentile)" << "\n\n";
+
+		std::uint64_t seen = 0;
+		std::size_t index = 0;
+		double half = 50.0;
+		double p = 0.0;
+		while (m_total)
+		{
+			std::uint64_t v = percentile(p);
+			while (index < m_counts.size() && highestAt(index) < v)
+			{
+				seen += m_counts[index++];
+			}
+			std::uint64_t total = std::min(m_total, seen + (index < m_counts.size() ? m_counts[index] : 0));
+			out << std::setprecision(3) << std::setw(12) << v / scale << " ";
+			out << std::setprecision(12) << std::setw(14) << p / 100.0 << " ";
+			out << std::setw(10) << total << " ";
+			if (p < 100.0)
+			{
+				out << std::setprecision(2) << std::setw(14) << 1.0 / (1.0 - p / 100.0);
+			}
+			out << '\n';
+			if (p >= 100.0 || total == m_total)
+			{
+				break;
+			}
+			p += half / ticksPerHalf;
+			if (p >= 100.0 - half - 1e-9)
+			{
+				half /= 2;
+			}
+			if (half < 1e-7)
+			{
+				p = 100.0;
+			}
+		}
+		out << std::setprecision(3);
+		out << "#[Mean    = " << std::setw(12) << mean() / scale << ", StdDeviation   = " << std::setw(12) << stddev() / scale << "]\n";
+		out << "#[Max     = " << std::setw(12) << max() / scale << ", Total count    = " << std::setw(12) << count() << "]\n";
+		out.flags(flags);
+		out.precision(precision);
+	}
+};
@@ -0,0 +1,506 @@
+// Need the following as the first include for a Visual Studio environment
+#include "stdafx.h"
+
+/*
+Load generator for the shortest path solver.
+
+Replays a stream of (src, dst) queries (workload.h) against ShortestPath
+and reports the throughput and the latency distribution (histogram.h).
+
+Two ways of applying load:
+	closed loop - each of the concurrency workers sends its next query as
+	              soon as the previous one is answered
+	open loop   - with --rate, query i is due at i / rate seconds from the
+	              start whatever happened before.  Its latency is counted
+	              from when it was due, so when the workers fall behind
+	              the backlog shows up in the percentiles instead of
+	              silently lowering the offered rate.
+
+With --store the queries whose source has a tree in the store
+(tree_store.h) are answered from the mapped tree, and --persist saves the
+trees of the most queried sources first, so a second run against the same
+store starts warm.  With --oracle every query is answered with the upper
+bound of a landmark distance oracle (oracle.h) instead, and the bounds
+are checked against exact solves of a sample of the queries.  A query
+the oracle has no bound for, and cannot rule out, is solved exactly.
+
+With --writes a writer thread publishes batches of edge cost changes to
+a VersionedGraph (snapshot.h) during the run, and every query pins the
+latest snapshot, to measure the readers' latency under updates.
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../dijkstra/dijkstra.h"
+#include "../dijkstra/executor.h"
+#include "../dijkstra/tree_store.h"
+#include "../dijkstra/oracle.h"
+#include "../dijkstra/snapshot.h"
+#include "../StaticLib1/random.h"
+#include "../StaticLib1/timer.h"
+#include "../StaticLib1/footprint.h"
+#include "histogram.h"
+#include "workload.h"
+
+using steady = std::chrono::steady_clock;
+
+// Load a "size" then "i j c" per line graph file, as read by mst
+bool loadGraph(const std::string& fname, std::shared_ptr<Graph>& g)
+{
+	std::ifstream in(fname);
+	int size;
+	if (!(in >> size) || size < 0)
+	{
+		return false;
+	}
+	std::vector<Edge> edges;
+	int src, dst, cost;
+	while (in >> src >> dst >> cost)
+	{
+		edges.push_back(Edge(src, dst, cost));
+	}
+	double density = size > 0 ? static_cast<double>(edges.size()) / (static_cast<double>(size) * size) : 0.0;
+	g = std::make_shared<Graph>(size, density);
+	g->build(edges);
+	return true;
+}
+
+struct RunResult
+{
+	LatencyHistogram latency;
+	std::size_t found = 0;
+	// Queries answered from a stored tree
+	std::size_t stored = 0;
+	double seconds = 0;
+};
+
+// Wait for the due time: sleep while it is far, then spin, as a sleep can
+// overshoot by much more than a query takes.
+void waitUntil(steady::time_point due)
+{
+	const auto spin = std::chrono::microseconds(200);
+	steady::time_point now = steady::now();
+	if (due - now > spin)
+	{
+		std::this_thread::sleep_until(due - spin);
+	}
+	while (steady::now() < due)
+	{
+		std::this_thread::yield();
+	}
+}
+
+// rate = 0: closed loop; store, oracle and versions may be null.  With
+// versions each query runs on the snapshot current when it starts.
+RunResult run(std::shared_ptr<const Graph> g, const std::vector<Query>& queries, unsigned concurrency, double rate,
+	TreeStore* store, const DistanceOracle* oracle, VersionedGraph* versions)
+{
+	Executor ex(concurrency);
+	std::atomic<std::size_t> next(0);
+	std::vector<LatencyHistogram> latency(concurrency);
+	std::vector<std::size_t> found(concurrency, 0);
+	std::vector<std::size_t> stored(concurrency, 0);
+	steady::time_point start = steady::now();
+
+	std::vector<std::future<void>> workers;
+	for (unsigned w = 0; w < concurrency; ++w)
+	{
+		workers.push_back(ex.submit([&, w]()
+		{
+			ShortestPath sp(g);
+			LatencyHistogram h;
+			std::size_t hits = 0;
+			std::size_t fromStore = 0;
+			for (;;)
+			{
+				std::size_t i = next.fetch_add(1, std::memory_order_relaxed);
+				if (i >= queries.size())
+				{
+					break;
+				}
+				steady::time_point begin = steady::now();
+				if (rate > 0)
+				{
+					begin = start + std::chrono::duration_cast<steady::duration>(std::chrono::duration<double>(i / rate));
+					waitUntil(begin);
+				}
+				std::shared_ptr<const StoredTree> tree = store ? store->find(queries[i].src) : nullptr;
+				if (oracle)
+				{
+					Estimate e = oracle->estimate(queries[i].src, queries[i].dst);
+					if (e.bounded)
+					{
+						++hits;
+					}
+					else if (e.reachable)
+					{
+						// No landmark bounds this pair; only a solve can tell
+						hits += sp.path(queries[i].src, queries[i].dst);
+					}
+				}
+				else if (tree)
+				{
+					hits += tree->distance(queries[i].dst) != INT_MAX;
+					++fromStore;
+				}
+				else if (versions)
+				{
+					VersionedGraph::Snapshot snapshot = versions->pin();
+					sp.rebind(snapshot.shared());
+					hits += sp.path(queries[i].src, queries[i].dst);
+				}
+				else
+				{
+					hits += sp.path(queries[i].src, queries[i].dst);
+				}
+				h.record(std::chrono::duration_cast<std::chrono::nanoseconds>(steady::now() - begin).count());
+			}
+			latency[w] = std::move(h);
+			found[w] = hits;
+			stored[w] = fromStore;
+		}));
+	}
+	for (auto& w : workers)
+	{
+		w.get();
+	}
+
+	RunResult result;
+	result.seconds = std::chrono::duration<double>(steady::now() - start).count();
+	for (unsigned w = 0; w < concurrency; ++w)
+	{
+		result.latency.merge(latency[w]);
+		result.found += found[w];
+		result.stored += stored[w];
+	}
+	return result;
+}
+
+// Usage: loadgen [graphfile] [--generate size density] [--queries file]
+//                [--workload uniform|zipf|local] [--count n] [--skew s]
+//                [--hops h] [--seed n] [--record file]
+//                [--concurrency c] [--rate qps] [--distribution]
+//                [--store dir] [--persist n] [--oracle k] [--oracle-file f]
+//                [--writes batches/s] [--batch n]
+// The graph is read from graphfile ("size" then "i j c" lines) or
+// generated.  The queries are replayed from --queries or drawn from the
+// workload; --record saves them for a later replay.  --concurrency sets
+// the worker count (default 1); --rate switches to an open loop at that
+// many queries per second.  --distribution prints the full percentile
+// distribution.  --store answers from the shortest path trees saved in
+// dir for this graph; --persist first saves the trees of the n most
+// queried sources which are not stored yet.  dir must exist.  --oracle
+// answers from a distance oracle of k landmarks, read from --oracle-file
+// if it holds one for this graph, otherwise built and saved there.
+// --writes publishes that many batches per second of --batch (default 64)
+// edge cost changes while the queries run.
+int main(int argc, char **argv)
+{
+	Timer t;
+	std::string graphFile;
+	std::string queryFile;
+	std::string recordFile;
+	int generateSize{ 0 };
+	double generateDensity{ 0.1 };
+	Workload workload{ Workload::Uniform };
+	std::size_t count{ 10000 };
+	double skew{ 1.0 };
+	int hops{ 3 };
+	std::uint64_t seed{ 1 };
+	unsigned concurrency{ 1 };
+	double rate{ 0 };
+	bool distribution{ false };
+	std::string storeDir;
+	int persist{ 0 };
+	int landmarks{ 0 };
+	std::string oracleFile;
+	double writes{ 0 };
+	int batch{ 64 };
+
+	for (int a = 1; a < argc; ++a)
+	{
+		std::string arg = argv[a];
+		if (arg == "--generate" && a + 2 < argc)
+		{
+			generateSize = std::atoi(argv[++a]);
+			generateDensity = std::atof(argv[++a]);
+		}
+		else if (arg == "--queries" && a + 1 < argc)
+		{
+			queryFile = argv[++a];
+		}
+		else if (arg == "--workload" && a + 1 < argc)
+		{
+			workload = parseWorkload(argv[++a]);
+		}
+		else if (arg == "--count" && a + 1 < argc)
+		{
+			count = std::strtoull(argv[++a], nullptr, 10);
+		}
+		else if (arg == "--skew" && a + 1 < argc)
+		{
+			skew = std::atof(argv[++a]);
+		}
+		else if (arg == "--hops" && a + 1 < argc)
+		{
+			hops = std::atoi(argv[++a]);
+		}
+		else if (arg == "--seed" && a + 1 < argc)
+		{
+			seed = std::strtoull(argv[++a], nullptr, 10);
+		}
+		else if (arg == "--record" && a + 1 < argc)
+		{
+			recordFile = argv[++a];
+		}
+		else if (arg == "--concurrency" && a + 1 < argc)
+		{
+			concurrency = static_cast<unsigned>(std::max(1, std::atoi(argv[++a])));
+		}
+		else if (arg == "--rate" && a + 1 < argc)
+		{
+			rate = std::atof(argv[++a]);
+		}
+		else if (arg == "--distribution")
+		{
+			distribution = true;
+		}
+		else if (arg == "--store" && a + 1 < argc)
+		{
+			storeDir = argv[++a];
+		}
+		else if (arg == "--persist" && a + 1 < argc)
+		{
+			persist = std::max(0, std::atoi(argv[++a]));
+		}
+		else if (arg == "--oracle" && a + 1 < argc)
+		{
+			landmarks = std::max(1, std::atoi(argv[++a]));
+		}
+		else if (arg == "--oracle-file" && a + 1 < argc)
+		{
+			oracleFile = argv[++a];
+		}
+		else if (arg == "--writes" && a + 1 < argc)
+		{
+			writes = std::atof(argv[++a]);
+		}
+		else if (arg == "--batch" && a + 1 < argc)
+		{
+			batch = std::max(1, std::atoi(argv[++a]));
+		}
+		else
+		{
+			graphFile = arg;
+		}
+	}
+
+	std::shared_ptr<Graph> g;
+	if (!graphFile.empty())
+	{
+		if (!loadGraph(graphFile, g))
+		{
+			std::cout << "Unable to read " << graphFile << std::endl;
+			return 1;
+		}
+	}
+	else
+	{
+		g = std::make_shared<Graph>(generateSize > 0 ? generateSize : 1000, generateDensity);
+		g->generate();
+	}
+
+	std::vector<Query> queries;
+	if (!queryFile.empty())
+	{
+		std::ifstream in(queryFile);
+		queries = readQueries(in);
+		// Queries for vertices the graph does not have are dropped
+		int size = g->vertices();
+		queries.erase(std::remove_if(queries.begin(), queries.end(), [size](const Query& q)
+		{
+			return q.src < 0 || q.src >= size || q.dst < 0 || q.dst >= size;
+		}), queries.end());
+	}
+	else
+	{
+		RandomStream rng(seed);
+		queries = makeQueries(*g, workload, count, rng, skew, hops);
+	}
+	if (!recordFile.empty())
+	{
+		std::ofstream out(recordFile);
+		writeQueries(out, queries);
+	}
+
+	std::cout << "Graph: " << g->vertices() << " vertices, " << g->edges() << " edges\n";
+	std::cout << "Queries: " << queries.size() << ", concurrency: " << concurrency;
+	if (rate > 0)
+	{
+		std::cout << ", open loop at " << rate << " queries/s\n";
+	}
+	else
+	{
+		std::cout << ", closed loop\n";
+	}
+
+	std::unique_ptr<TreeStore> store;
+	if (!storeDir.empty())
+	{
+		store.reset(new TreeStore(storeDir, *g));
+		// Sources by query count, most queried first
+		std::vector<int> counts(g->vertices(), 0);
+		for (const Query& q : queries)
+		{
+			++counts[q.src];
+		}
+		std::vector<int> sources(g->vertices());
+		std::iota(sources.begin(), sources.end(), 0);
+		std::stable_sort(sources.begin(), sources.end(), [&counts](int a, int b) { return counts[a] > counts[b]; });
+		ShortestPath sp(g);
+		Timer pt;
+		int saved = 0;
+		for (int i = 0; i < persist && i < static_cast<int>(sources.size()) && counts[sources[i]] > 0; ++i)
+		{
+			if (!store->find(sources[i]))
+			{
+				if (!store->save(sp, sources[i]))
+				{
+					std::cout << "Unable to write " << store->fileName(sources[i]) << std::endl;
+					return 1;
+				}
+				++saved;
+			}
+		}
+		std::cout << "Tree store: " << storeDir << ", graph checksum " << std::hex << store->checksum() << std::dec;
+		std::cout << ", saved " << saved << " trees in " << pt.elapsed() << "s\n";
+	}
+
+	std::unique_ptr<DistanceOracle> oracle;
+	if (landmarks > 0)
+	{
+		Timer ot;
+		if (!oracleFile.empty())
+		{
+			std::ifstream in(oracleFile, std::ios::binary);
+			oracle = DistanceOracle::read(in);
+			if (oracle && oracle->checksum() != g->checksum())
+			{
+				oracle.reset();
+			}
+		}
+		bool loaded = oracle != nullptr;
+		if (!oracle)
+		{
+			Executor ex(concurrency);
+			oracle.reset(new DistanceOracle(g, landmarks, ex, Landmarks::Farthest, seed));
+			if (!oracleFile.empty())
+			{
+				std::ofstream out(oracleFile, std::ios::binary);
+				oracle->write(out);
+			}
+		}
+		std::cout << "Oracle: " << oracle->landmarks() << " landmarks, " << oracle->memoryBytes() << " bytes, ";
+		std::cout << (loaded ? "loaded" : "built") << " in " << ot.elapsed() << "s\n";
+
+		// Bounds against exact costs on a sample of the queries
+		ShortestPath sp(g);
+		std::size_t sample = std::min<std::size_t>(queries.size(), 1000);
+		std::size_t exact = 0;
+		std::size_t outside = 0;
+		std::size_t bounded = 0;
+		std::size_t unbounded = 0;
+		double stretch = 0;
+		for (std::size_t i = 0; i < sample; ++i)
+		{
+			const Query& q = queries[i];
+			int cost = sp.path(q.src, q.dst) ? sp.pathCost() : INT_MAX;
+			Estimate e = oracle->estimate(q.src, q.dst);
+			outside += cost < e.lower || cost > e.upper;
+			exact += e.bounded ? cost == e.upper : !e.reachable;
+			unbounded += e.reachable && !e.bounded;
+			if (e.bounded && cost != INT_MAX && cost > 0)
+			{
+				++bounded;
+				stretch += static_cast<double>(e.upper) / cost;
+			}
+		}
+		std::cout << "Oracle accuracy on " << sample << " queries: " << exact << " exact, mean stretch ";
+		std::cout << (bounded ? stretch / bounded : 1.0) << ", " << unbounded << " without a bound, ";
+		std::cout << outside << " outside the bounds\n";
+	}
+
+	std::unique_ptr<VersionedGraph> versions;
+	std::atomic<bool> writing(false);
+	std::thread writer;
+	if (writes > 0)
+	{
+		versions.reset(new VersionedGraph(*g, static_cast<int>(concurrency) * 2));
+		writing = true;
+		// Batches of new costs for existing edges, so the graph keeps its
+		// shape and the queries stay comparable
+		writer = std::thread([&]()
+		{
+			RandomStream rng(seed, 1);
+			auto period = std::chrono::duration_cast<steady::duration>(std::chrono::duration<double>(1.0 / writes));
+			steady::time_point due = steady::now();
+			while (writing)
+			{
+				std::vector<Edge> changes;
+				{
+					VersionedGraph::Snapshot current = versions->pin();
+					for (int c = 0; c < batch && current->edges() > 0; ++c)
+					{
+						int v = rng.uniform(0, current->vertices() - 1);
+						IdRange ids = current->neighbors(Vertex(v));
+						if (!ids.empty())
+						{
+							changes.push_back(Edge(v, ids[rng.uniform(0, ids.size() - 1)], rng.uniform(1, 10)));
+						}
+					}
+				}
+				versions->update(std::move(changes));
+				due += period;
+				waitUntil(due);
+			}
+		});
+	}
+
+	RunResult r = run(g, queries, concurrency, rate, store.get(), oracle.get(), versions.get());
+	if (versions)
+	{
+		writing = false;
+		writer.join();
+		VersionedGraph::Snapshot last = versions->pin();
+		std::cout << "Snapshots published: " << last.version() << ", waiting for readers: " << versions->retired() << '\n';
+	}
+	const LatencyHistogram& h = r.latency;
+	std::cout << "Found: " << r.found << " paths in " << r.seconds << "s, ";
+	if (store)
+	{
+		std::cout << r.stored << " answered from stored trees, ";
+	}
+	std::cout << "throughput: " << (r.seconds > 0 ? queries.size() / r.seconds : 0.0) << " queries/s\n";
+	std::cout << "Latency (us): p50 " << h.percentile(50) / 1e3 << ", p90 " << h.percentile(90) / 1e3;
+	std::cout << ", p99 " << h.percentile(99) / 1e3 << ", p99.9 " << h.percentile(99.9) / 1e3;
+	std::cout << ", max " << h.max() / 1e3 << ", mean " << h.mean() / 1e3 << '\n';
+	if (distribution)
+	{
+		h.writeDistribution(std::cout);
+	}
+	std::cout << "Graph bytes: " << g->memoryBytes() << ", solver bytes: " << ShortestPath(g).memoryBytes();
+	std::cout << " per worker\n";
+	footprint::report(std::cout);
+	std::cout << "Total processing time: " << t.elapsed() << std::endl;
+	return 0;
+}
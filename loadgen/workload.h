@@ -0,0 +1,154 @@
+/*
+Query streams for the load generator.
+
+A stream is a list of (src, dst) pairs, either replayed from a file of
+"src dst" lines or drawn from one of:
+	uniform - src and dst uniform over the vertices
+	zipf    - src and dst Zipf distributed with exponent skew over a random
+	          ranking of the vertices: a few hot vertices get most queries
+	local   - src uniform, dst the end of a random walk of up to hops
+	          edges from src, the short trips of a road network
+Streams drawn from the same seed are the same, so a run can be repeated
+exactly or recorded with writeQueries and replayed elsewhere.
+*/
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <numeric>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "../dijkstra/dijkstra.h"
+#include "../StaticLib1/random.h"
+
+struct Query
+{
+	int src;
+	int dst;
+};
+
+enum class Workload
+{
+	Uniform,
+	Zipf,
+	Local
+};
+
+inline Workload parseWorkload(const std::string& name)
+{
+	if (name == "zipf")
+	{
+		return Workload::Zipf;
+	}
+	if (name == "local")
+	{
+		return Workload::Local;
+	}
+	return Workload::Uniform;
+}
+
+// Pairs of "src dst", one per line; stops at the first malformed line
+inline std::vector<Query> readQueries(std::istream& in)
+{
+	std::vector<Query> queries;
+	Query q;
+	while (in >> q.src >> q.dst)
+	{
+		queries.push_back(q);
+	}
+	return queries;
+}
+
+inline void writeQueries(std::ostream& out, const std::vector<Query>& queries)
+{
+	for (auto& q : queries)
+	{
+		out << q.src << " " << q.dst << '\n';
+	}
+}
+
+// Draws vertex i of a random ranking with probability proportional to
+// 1 / (rank + 1)^skew, by binary search of the cumulative distribution.
+class ZipfSampler
+{
+private:
+	std::vector<double> m_cdf;
+	std::vector<int> m_vertex;
+public:
+	ZipfSampler(int size, double skew, RandomStream& rng) : m_cdf(size), m_vertex(size)
+	{
+		double total = 0;
+		for (int r = 0; r < size; ++r)
+		{
+			total += 1.0 / std::pow(r + 1.0, skew);
+			m_cdf[r] = total;
+		}
+		for (auto& c : m_cdf)
+		{
+			c /= total;
+		}
+		std::iota(m_vertex.begin(), m_vertex.end(), 0);
+		for (int i = size - 1; i > 0; --i)
+		{
+			std::swap(m_vertex[i], m_vertex[rng.uniform(0, i)]);
+		}
+	}
+
+	int operator()(RandomStream& rng) const
+	{
+		double u = rng.uniform(0.0, 1.0);
+		std::size_t r = std::upper_bound(m_cdf.begin(), m_cdf.end(), u) - m_cdf.begin();
+		return m_vertex[std::min(r, m_vertex.size() - 1)];
+	}
+};
+
+inline std::vector<Query> makeQueries(const Graph& g, Workload w, std::size_t count,
+	RandomStream& rng, double skew = 1.0, int hops = 3)
+{
+	std::vector<Query> queries(count);
+	int size = g.vertices();
+	if (size == 0)
+	{
+		return std::vector<Query>();
+	}
+	switch (w)
+	{
+	case Workload::Zipf:
+	{
+		ZipfSampler zipf(size, skew, rng);
+		for (auto& q : queries)
+		{
+			q.src = zipf(rng);
+			q.dst = zipf(rng);
+		}
+		break;
+	}
+	case Workload::Local:
+		for (auto& q : queries)
+		{
+			q.src = rng.uniform(0, size - 1);
+			q.dst = q.src;
+			for (int h = rng.uniform(1, std::max(1, hops)); h > 0; --h)
+			{
+				IdRange next = g.neighbors(Vertex(q.dst));
+				if (next.empty())
+				{
+					break;
+				}
+				q.dst = next[rng.uniform(0, next.size() - 1)];
+			}
+		}
+		break;
+	default:
+		for (auto& q : queries)
+		{
+			q.src = rng.uniform(0, size - 1);
+			q.dst = rng.uniform(0, size - 1);
+		}
+		break;
+	}
+	return queries;
+}
@@ -0,0 +1,388 @@
+// Need the following as the first include for a Visual Studio environment
+#include "stdafx.h"
+
+/*
+External memory Kruskal.
+
+The data file has the same format as the one read by Graph::populate():
+the first line is the graph size, the rest are "i j c" edge definitions.
+
+Phase 1 - run formation:
+	Edges are read into a chunk of at most m_chunkEdges entries.  When the
+	chunk is full it is reduced to its minimum spanning forest; an edge
+	that is the heaviest on a cycle inside the chunk can never be part of
+	the final tree.  The forest (at most V-1 edges, already in ascending
+	cost order) is spilled to disk as a run.
+Phase 2 - merge:
+	The runs are merged by cost and fed to a union-find Kruskal, which
+	stops as soon as V-1 edges have been selected.
+
+If the whole file fits in a single chunk nothing is written to disk.
+*/
+#include "kruskal.h"
+#include "../StaticLib1/graph_io.h"
+#include "../StaticLib1/trace.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+
+// Below this many edges filterKruskal simply sorts and scans.
+static const std::ptrdiff_t kruskalThreshold = 1024;
+// Maximum number of runs kept open during a merge.  When reached the runs
+// are collapsed into a single forest run.
+static const std::size_t maxRuns = 64;
+// Stream buffer used for each run file.
+static const std::size_t runBufferSize = 1 << 16;
+
+
+// DisjointSet methods
+
+void DisjointSet::reset(int size)
+{
+	m_parent.resize(size);
+	m_rank.assign(size, 0);
+	for (int i = 0; i < size; ++i)
+	{
+		m_parent[i] = i;
+	}
+}
+
+int DisjointSet::find(int v)
+{
+	while (m_parent[v] != v)
+	{
+		// Path halving: point every other node at its grandparent.
+		m_parent[v] = m_parent[m_parent[v]];
+		v = m_parent[v];
+	}
+	return v;
+}
+
+bool DisjointSet::unite(int a, int b)
+{
+	a = find(a);
+	b = find(b);
+	if (a == b)
+	{
+		return false;
+	}
+	if (m_rank[a] < m_rank[b])
+	{
+		std::swap(a, b);
+	}
+	m_parent[b] = a;
+	if (m_rank[a] == m_rank[b])
+	{
+		++m_rank[a];
+	}
+	return true;
+}
+
+
+// Helpers
+
+static bool byCost(const WeightedEdge& e1, const WeightedEdge& e2)
+{
+	return e1.cost < e2.cost;
+}
+
+// Parse "i j c" without the temporary strings used by Graph::populate().
+bool parseEdge(const std::string& line, WeightedEdge& e)
+{
+	int values[3];
+	std::size_t pos = 0;
+	for (int k = 0; k < 3; ++k)
+	{
+		while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t'))
+		{
+			++pos;
+		}
+		bool negative = pos < line.size() && line[pos] == '-';
+		if (negative)
+		{
+			++pos;
+		}
+		if (pos == line.size() || line[pos] < '0' || line[pos] > '9')
+		{
+			return false;
+		}
+		int value = 0;
+		while (pos < line.size() && line[pos] >= '0' && line[pos] <= '9')
+		{
+			int digit = line[pos] - '0';
+			if (value > (INT_MAX - digit) / 10)
+			{
+				// Too long for an int
+				return false;
+			}
+			value = value * 10 + digit;
+			++pos;
+		}
+		values[k] = negative ? -value : value;
+	}
+	e.src = values[0];
+	e.dst = values[1];
+	e.cost = values[2];
+	return true;
+}
+
+void filterKruskal(WeightedEdge* first, WeightedEdge* last, DisjointSet& sets,
+	std::vector<WeightedEdge>& tree, std::size_t limit)
+{
+	if (first == last || tree.size() >= limit)
+	{
+		return;
+	}
+
+	std::ptrdiff_t n = last - first;
+	if (n <= kruskalThreshold)
+	{
+		std::sort(first, last, byCost);
+		for (WeightedEdge* e = first; e != last && tree.size() < limit; ++e)
+		{
+			if (sets.unite(e->src, e->dst))
+			{
+				tree.push_back(*e);
+			}
+		}
+		return;
+	}
+
+	// Median of three pivot
+	int a = first->cost;
+	int b = first[n / 2].cost;
+	int c = last[-1].cost;
+	int pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+	// Split into light (< pivot), equal and heavy (> pivot) edges.
+	WeightedEdge* equal = std::partition(first, last,
+		[pivot](const WeightedEdge& e) { return e.cost < pivot; });
+	WeightedEdge* heavy = std::partition(equal, last,
+		[pivot](const WeightedEdge& e) { return e.cost == pivot; });
+
+	filterKruskal(first, equal, sets, tree, limit);
+
+	// Edges equal to the pivot need no sorting amongst themselves.
+	for (WeightedEdge* e = equal; e != heavy && tree.size() < limit; ++e)
+	{
+		if (sets.unite(e->src, e->dst))
+		{
+			tree.push_back(*e);
+		}
+	}
+
+	// Filter: drop heavy edges which would only close a cycle.
+	WeightedEdge* kept = std::partition(heavy, last,
+		[&sets](const WeightedEdge& e) { return !sets.connected(e.src, e.dst); });
+	filterKruskal(heavy, kept, sets, tree, limit);
+}
+
+
+// ExternalMST methods
+
+// Reduce the chunk to its spanning forest and write it out as a run.
+// False if the run cannot be written.
+bool ExternalMST::spill(std::vector<WeightedEdge>& chunk)
+{
+	std::vector<WeightedEdge> forest;
+	m_sets.reset(m_size);
+	filterKruskal(chunk.data(), chunk.data() + chunk.size(), m_sets, forest, m_size - 1);
+
+	std::string fname = m_tmpdir + "/mst_run_" +
+		std::to_string(reinterpret_cast<std::uintptr_t>(this)) + "_" +
+		std::to_string(m_runs.size()) + ".bin";
+	std::ofstream outfile(fname, std::ios::binary);
+	outfile.write(reinterpret_cast<const char*>(forest.data()),
+		forest.size() * sizeof(WeightedEdge));
+	outfile.close();
+	if (!outfile)
+	{
+		std::remove(fname.c_str());
+		m_error = "Unable to write run file " + fname;
+		return false;
+	}
+	m_runs.push_back(fname);
+
+	if (m_runs.size() == maxRuns)
+	{
+		// Too many runs open at once - collapse them into one forest.
+		merge();
+		clearRuns();
+		bool written = spill(m_tree);
+		m_tree.clear();
+		return written;
+	}
+	return true;
+}
+
+// K-way merge of the runs into a union-find Kruskal.  The result is left
+// in m_tree.
+void ExternalMST::merge()
+{
+	struct Head
+	{
+		WeightedEdge edge;
+		std::size_t run;
+	};
+	auto heavier = [](const Head& h1, const Head& h2) { return h1.edge.cost > h2.edge.cost; };
+	std::priority_queue<Head, std::vector<Head>, decltype(heavier)> heads(heavier);
+
+	std::vector<std::unique_ptr<std::ifstream>> infiles;
+	std::vector<std::unique_ptr<char[]>> buffers;
+	for (std::size_t i = 0; i < m_runs.size(); ++i)
+	{
+		buffers.emplace_back(new char[runBufferSize]);
+		infiles.emplace_back(new std::ifstream);
+		infiles[i]->rdbuf()->pubsetbuf(buffers[i].get(), runBufferSize);
+		infiles[i]->open(m_runs[i], std::ios::binary);
+
+		Head h{ {}, i };
+		if (infiles[i]->read(reinterpret_cast<char*>(&h.edge), sizeof(WeightedEdge)))
+		{
+			heads.push(h);
+		}
+	}
+
+	m_sets.reset(m_size);
+	m_tree.clear();
+	std::size_t limit = m_size - 1;
+	while (!heads.empty() && m_tree.size() < limit)
+	{
+		Head h = heads.top();
+		heads.pop();
+		if (m_sets.unite(h.edge.src, h.edge.dst))
+		{
+			m_tree.push_back(h.edge);
+		}
+		if (infiles[h.run]->read(reinterpret_cast<char*>(&h.edge), sizeof(WeightedEdge)))
+		{
+			heads.push(h);
+		}
+	}
+}
+
+void ExternalMST::clearRuns()
+{
+	for (auto& fname : m_runs)
+	{
+		std::remove(fname.c_str());
+	}
+	m_runs.clear();
+}
+
+// Stream the data file and compute the minimum spanning tree.
+bool ExternalMST::compute(const std::string& fname)
+{
+	TRACE_SCOPE("kruskal");
+	m_error.clear();
+	std::ifstream infile(fname);
+	if (!infile)
+	{
+		// unable to open the given file.
+		m_error = "Unable to read " + fname;
+		return false;
+	}
+
+	std::string strSize;
+	std::getline(infile, strSize);
+	try
+	{
+		m_size = std::stoi(strSize);
+	}
+	catch (const std::exception&)
+	{
+		// std::invalid_argument, or std::out_of_range for a size too large
+		m_error = "Unable to convert graph size to int in " + fname;
+		return false;
+	}
+
+	clearRuns();
+	m_tree.clear();
+	m_mstcost = 0;
+	if (m_size <= 0)
+	{
+		return true;
+	}
+
+	std::vector<WeightedEdge> chunk;
+	chunk.reserve(m_chunkEdges);
+	std::string strEdge;
+	long long line = 1;
+	while (std::getline(infile, strEdge))
+	{
+		++line;
+		WeightedEdge e;
+		if (!parseEdge(strEdge, e))
+		{
+			continue;
+		}
+
+		bool valid = (e.src < m_size) && (e.src >= 0);
+		valid = valid && (e.dst < m_size) && (e.dst >= 0);
+		if (!valid)
+		{
+			m_error = "Vertex out of range on line " + std::to_string(line) + " of " + fname;
+			clearRuns();
+			return false;
+		}
+		if (e.src == e.dst)
+		{
+			continue;
+		}
+
+		chunk.push_back(e);
+		if (chunk.size() == m_chunkEdges)
+		{
+			if (!spill(chunk))
+			{
+				clearRuns();
+				return false;
+			}
+			chunk.clear();
+		}
+	}
+	infile.close();
+
+	if (m_runs.empty())
+	{
+		// Everything fitted in memory - no need to touch the disk.
+		m_sets.reset(m_size);
+		filterKruskal(chunk.data(), chunk.data() + chunk.size(), m_sets, m_tree, m_size - 1);
+	}
+	else
+	{
+		if (!chunk.empty() && !spill(chunk))
+		{
+			clearRuns();
+			return false;
+		}
+		// Release the chunk before the merge, only O(V) is needed from here.
+		std::vector<WeightedEdge>().swap(chunk);
+		merge();
+	}
+	clearRuns();
+
+	for (auto& e : m_tree)
+	{
+		m_mstcost += e.cost;
+	}
+	return true;
+}
+
+std::ostream& operator<<(std::ostream& out, const ExternalMST& mst)
+{
+	BufferedWriter w(out);
+	for (auto& e : mst.m_tree)
+	{
+		w.put(static_cast<long long>(e.src)).put(' ');
+		w.put(static_cast<long long>(e.dst)).put(' ');
+		w.put(static_cast<long long>(e.cost)).put('\n');
+	}
+	return out;
+}
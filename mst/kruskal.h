@@ -0,0 +1,86 @@
+/*
+Class definitions for the external memory (streaming) minimum spanning tree.
+Unlike the Prim implementation in mst.cpp, the edge file is never loaded
+into a V x V matrix.  Edges are read in bounded chunks, each chunk is
+reduced to its own spanning forest (filter-Kruskal), sorted and spilled to
+disk as a run.  The runs are then merged and fed to a union-find Kruskal.
+*/
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// An edge as read from the data file: "i j c"
+struct WeightedEdge
+{
+	int src;
+	int dst;
+	int cost;
+};
+
+// Disjoint set (union-find) ADT
+// Uses union by rank and path halving, so both operations are
+// effectively constant time.
+class DisjointSet
+{
+private:
+	std::vector<int> m_parent;
+	std::vector<unsigned char> m_rank;
+
+public:
+	DisjointSet(int size = 0) { reset(size); };
+	void reset(int size);
+	int find(int v);
+	bool unite(int a, int b);
+	bool connected(int a, int b) { return find(a) == find(b); };
+};
+
+// ExternalMST ADT
+// Resident memory is O(V) plus one chunk of edges; the number of edges in
+// the data file is not bounded by physical memory.
+class ExternalMST
+{
+private:
+	int m_size;
+	long long m_mstcost;
+	std::size_t m_chunkEdges;
+	std::string m_tmpdir;
+	DisjointSet m_sets;
+	std::vector<WeightedEdge> m_tree;
+	std::vector<std::string> m_runs;
+	std::string m_error;
+
+	bool spill(std::vector<WeightedEdge>& chunk);
+	void merge();
+	void clearRuns();
+
+public:
+	// chunkEdges is the number of edges held in memory at any one time.
+	ExternalMST(std::size_t chunkEdges = 1 << 20, std::string tmpdir = ".")
+		: m_size(0), m_mstcost(0), m_chunkEdges(chunkEdges), m_tmpdir(tmpdir)
+	{};
+	~ExternalMST() { clearRuns(); };
+
+	int vertices() const { return m_size; };
+	// False if the data file cannot be read, names a vertex out of range
+	// or a run cannot be written; error() then says which.
+	bool compute(const std::string& fname);
+	const std::string& error() const { return m_error; };
+	long long cost() const { return m_mstcost; };
+	const std::vector<WeightedEdge>& tree() const { return m_tree; };
+
+	friend std::ostream& operator<<(std::ostream& out, const ExternalMST& mst);
+};
+
+// Parse an "i j c" line of the data file; false if it is not one or a
+// value does not fit an int
+bool parseEdge(const std::string& line, WeightedEdge& e);
+
+// Reduce the edges in [first, last) to the minimum spanning forest they
+// define, appending the selected edges to tree in ascending cost order.
+// Heavy edges whose endpoints are already connected are filtered out
+// before they are ever sorted.
+void filterKruskal(WeightedEdge* first, WeightedEdge* last, DisjointSet& sets,
+	std::vector<WeightedEdge>& tree, std::size_t limit);
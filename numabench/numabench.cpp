@@ -0,0 +1,197 @@
+// Need the following as the first include for a Visual Studio environment
+#include "stdafx.h"
+
+/*
+Benchmark of the memory placement of the matrix graphs.
+
+Runs matrix Dijkstra queries (the O(V^2) row scan of the dijkstra and mst
+solvers) on a pool of threads against one large generated graph, placed
+in turn as:
+	first touch - the matrix zeroed and filled by the main thread, so it
+	              all lives on the main thread's node; workers float
+	interleaved - the matrix pages spread round robin over the nodes;
+	              workers pinned round robin to the nodes
+	replicated  - one copy of the matrix per node; workers pinned and
+	              reading the copy of their own node
+each with normal and with huge pages.  The solver arrays are allocated
+by the worker running the queries, so they are local to it whenever the
+worker is pinned.  On a single node machine the placements only differ
+in pinning and page size.
+*/
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../StaticLib1/matrix_graph.h"
+#include "../StaticLib1/kernels.h"
+#include "../StaticLib1/numa.h"
+#include "../StaticLib1/random.h"
+#include "../StaticLib1/timer.h"
+#include "../dijkstra/executor.h"
+
+// Random matrix graph built with the given page flags
+class BenchGraph : public MatrixGraph
+{
+public:
+	BenchGraph(int size, double density, std::uint64_t seed, MatrixMemory memory) : MatrixGraph(size)
+	{
+		m_matrix = Matrix<int>(size, size, memory);
+		RandomStream rng(seed);
+		std::vector<double> draws(size);
+		std::vector<int> costs(size);
+		for (int i = 0; i < size; ++i)
+		{
+			rng.fill(draws.data(), draws.size(), 0.0, 1.0);
+			rng.fill(costs.data(), costs.size(), 1, 10);
+			int* row = m_matrix[i];
+			for (int j = 0; j < size; ++j)
+			{
+				row[j] = (i != j && density > draws[j]) ? costs[j] : 0;
+			}
+		}
+	}
+	bool hugePages() const { return m_matrix.hugePages(); };
+};
+
+// Dijkstra over the matrix rows, as ShortestPath in dijkstra.cpp
+int matrixPath(const MatrixGraph& g, int src, int dst, std::vector<int>& distance, std::vector<unsigned char>& visited)
+{
+	int size = g.vertices();
+	std::fill(distance.begin(), distance.end(), INT_MAX);
+	std::fill(visited.begin(), visited.end(), 0);
+	distance[src] = 0;
+	for (int i = 0; i < size; ++i)
+	{
+		int m = core::minimumUnvisited(distance.data(), visited.data(), size);
+		if (m < 0 || m == dst)
+		{
+			break;
+		}
+		visited[m] = 1;
+		int base = distance[m];
+		g.forEachNeighbor(m, [&](int n, int cost)
+		{
+			if (!visited[n] && base + cost < distance[n])
+			{
+				distance[n] = base + cost;
+			}
+		});
+	}
+	return distance[dst];
+}
+
+// Queries per second of threads workers running queries each; graphOf()
+// gives the graph a worker reads.
+template <class GraphOf>
+double run(GraphOf graphOf, int size, unsigned threads, bool pinned, int queries, std::uint64_t seed, long long& checksum)
+{
+	Executor ex(threads, pinned);
+	std::atomic<long long> total(0);
+	std::vector<std::future<void>> workers;
+	Timer t;
+	for (unsigned w = 0; w < threads; ++w)
+	{
+		workers.push_back(ex.submit([&, w]()
+		{
+			const MatrixGraph& g = graphOf();
+			std::vector<int> distance(size);
+			std::vector<unsigned char> visited(size);
+			RandomStream rng(seed, w);
+			long long sum = 0;
+			for (int q = 0; q < queries; ++q)
+			{
+				int d = matrixPath(g, rng.uniform(0, size - 1), rng.uniform(0, size - 1), distance, visited);
+				sum += d == INT_MAX ? 0 : d;
+			}
+			total += sum;
+		}));
+	}
+	for (auto& w : workers)
+	{
+		w.get();
+	}
+	double seconds = t.elapsed();
+	checksum = total;
+	return seconds > 0 ? threads * queries / seconds : 0.0;
+}
+
+// Usage: numabench [--size n] [--density d] [--threads t] [--queries q]
+//                  [--seed n]
+// size defaults to 8000 vertices (a 256MB matrix), threads to one per
+// hardware thread and queries to 20 per thread.
+int main(int argc, char **argv)
+{
+	int size{ 8000 };
+	double density{ 0.1 };
+	unsigned threads{ 0 };
+	int queries{ 20 };
+	std::uint64_t seed{ 1 };
+	for (int a = 1; a < argc; ++a)
+	{
+		std::string arg = argv[a];
+		if (arg == "--size" && a + 1 < argc)
+		{
+			size = std::max(2, std::atoi(argv[++a]));
+		}
+		else if (arg == "--density" && a + 1 < argc)
+		{
+			density = std::atof(argv[++a]);
+		}
+		else if (arg == "--threads" && a + 1 < argc)
+		{
+			threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++a])));
+		}
+		else if (arg == "--queries" && a + 1 < argc)
+		{
+			queries = std::max(1, std::atoi(argv[++a]));
+		}
+		else if (arg == "--seed" && a + 1 < argc)
+		{
+			seed = std::strtoull(argv[++a], nullptr, 10);
+		}
+	}
+	if (threads == 0)
+	{
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	std::cout << "NUMA nodes: " << numa::nodes() << ", threads: " << threads;
+	std::cout << ", graph: " << size << " vertices, density " << density << '\n';
+	std::cout << std::left << std::setw(14) << "placement" << std::setw(8) << "pages";
+	std::cout << std::right << std::setw(14) << "queries/s" << std::setw(14) << "checksum" << '\n';
+	auto report = [](const char* placement, bool huge, double rate, long long checksum)
+	{
+		std::cout << std::left << std::setw(14) << placement << std::setw(8) << (huge ? "huge" : "normal");
+		std::cout << std::right << std::setw(14) << std::fixed << std::setprecision(1) << rate;
+		std::cout << std::setw(14) << checksum << '\n';
+	};
+
+	for (bool huge : { false, true })
+	{
+		MatrixMemory pages = huge ? MatrixMemory::HugePages : MatrixMemory::Default;
+		long long checksum = 0;
+		{
+			BenchGraph g(size, density, seed, pages);
+			double rate = run([&g]() -> const MatrixGraph& { return g; }, size, threads, false, queries, seed, checksum);
+			report("first touch", g.hugePages(), rate, checksum);
+
+			numa::Replicated<BenchGraph> copies(g);
+			rate = run([&copies]() -> const MatrixGraph& { return copies.local(); }, size, threads, true, queries, seed, checksum);
+			report("replicated", g.hugePages(), rate, checksum);
+		}
+		{
+			BenchGraph g(size, density, seed, pages | MatrixMemory::Interleaved);
+			double rate = run([&g]() -> const MatrixGraph& { return g; }, size, threads, true, queries, seed, checksum);
+			report("interleaved", g.hugePages(), rate, checksum);
+		}
+	}
+	return 0;
+}
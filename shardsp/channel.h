@@ -0,0 +1,216 @@
+/*
+Messages between the coordinator and the shard worker processes.
+
+A Channel wraps a connected stream socket (a socketpair end for workers
+forked on this machine, or a TCP socket when the shards run on several)
+and carries framed messages:
+
+	type, a, b, count    - four 32 bit words
+	count updates        - vertex, distance pairs
+
+	Ready     worker -> coordinator once the shard is loaded,
+	          a = edges, b = cut edges
+	Start     a = src; every worker resets for a search from src
+	Updates   coordinator -> worker: the inbox of a superstep;
+	          worker -> coordinator: the updates it produced
+	Distances coordinator -> worker: asks for the distances;
+	          worker -> coordinator: (v, distance) for its vertices
+	Quit      the worker exits
+
+Both ends run on the same kind of machine, so the words are sent in host
+byte order.  Sends never raise SIGPIPE: a peer that has gone away fails
+the send with EPIPE, which the caller sees as a failed worker.  POSIX
+only.
+*/
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "shard.h"
+
+// macOS has no MSG_NOSIGNAL; the socket is set to SO_NOSIGPIPE instead
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+enum class MessageType : std::uint32_t
+{
+	Ready,
+	Start,
+	Updates,
+	Distances,
+	Quit
+};
+
+struct Message
+{
+	MessageType type = MessageType::Quit;
+	int a = 0;
+	int b = 0;
+	std::vector<Update> updates;
+};
+
+// Channel ADT
+// Owns the socket; a failed send or receive means the other end is gone.
+class Channel
+{
+private:
+	int m_fd;
+	std::size_t m_bytesSent;
+	std::vector<std::uint32_t> m_buffer;
+
+	bool writeAll(const void* data, std::size_t n)
+	{
+		const char* p = static_cast<const char*>(data);
+		while (n > 0)
+		{
+			ssize_t done = ::send(m_fd, p, n, MSG_NOSIGNAL);
+			if (done < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (done <= 0)
+			{
+				return false;
+			}
+			p += done;
+			n -= static_cast<std::size_t>(done);
+		}
+		return true;
+	}
+
+	bool readAll(void* data, std::size_t n)
+	{
+		char* p = static_cast<char*>(data);
+		while (n > 0)
+		{
+			ssize_t done = ::read(m_fd, p, n);
+			if (done < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (done <= 0)
+			{
+				return false;
+			}
+			p += done;
+			n -= static_cast<std::size_t>(done);
+		}
+		return true;
+	}
+
+public:
+	explicit Channel(int fd) : m_fd(fd), m_bytesSent(0)
+	{
+#ifdef SO_NOSIGPIPE
+		int on = 1;
+		setsockopt(m_fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+	};
+	Channel(Channel&& c) noexcept : m_fd(c.m_fd), m_bytesSent(c.m_bytesSent), m_buffer(std::move(c.m_buffer))
+	{
+		c.m_fd = -1;
+	}
+	Channel(const Channel&) = delete;
+	Channel& operator=(const Channel&) = delete;
+	~Channel()
+	{
+		if (m_fd >= 0)
+		{
+			::close(m_fd);
+		}
+	}
+
+	std::size_t bytesSent() const { return m_bytesSent; };
+
+	// One write per message
+	bool send(const Message& m)
+	{
+		m_buffer.resize(4 + 2 * m.updates.size());
+		m_buffer[0] = static_cast<std::uint32_t>(m.type);
+		m_buffer[1] = static_cast<std::uint32_t>(m.a);
+		m_buffer[2] = static_cast<std::uint32_t>(m.b);
+		m_buffer[3] = static_cast<std::uint32_t>(m.updates.size());
+		for (std::size_t i = 0; i < m.updates.size(); ++i)
+		{
+			m_buffer[4 + 2 * i] = static_cast<std::uint32_t>(m.updates[i].vertex);
+			m_buffer[5 + 2 * i] = static_cast<std::uint32_t>(m.updates[i].distance);
+		}
+		std::size_t n = m_buffer.size() * sizeof(std::uint32_t);
+		m_bytesSent += n;
+		return writeAll(m_buffer.data(), n);
+	}
+
+	bool receive(Message& m)
+	{
+		std::uint32_t header[4];
+		if (!readAll(header, sizeof(header)))
+		{
+			return false;
+		}
+		m.type = static_cast<MessageType>(header[0]);
+		m.a = static_cast<int>(header[1]);
+		m.b = static_cast<int>(header[2]);
+		m_buffer.resize(2 * static_cast<std::size_t>(header[3]));
+		if (!readAll(m_buffer.data(), m_buffer.size() * sizeof(std::uint32_t)))
+		{
+			return false;
+		}
+		m.updates.resize(header[3]);
+		for (std::size_t i = 0; i < m.updates.size(); ++i)
+		{
+			m.updates[i].vertex = static_cast<int>(m_buffer[2 * i]);
+			m.updates[i].distance = static_cast<int>(m_buffer[2 * i + 1]);
+		}
+		return true;
+	}
+};
+
+// Worker side: answer the coordinator until it sends Quit or goes away
+inline void serveShard(Channel& channel, const Shard& shard)
+{
+	ShardWorker worker(shard);
+	Message m;
+	m.type = MessageType::Ready;
+	m.a = shard.edges();
+	m.b = shard.cutEdges();
+	if (!channel.send(m))
+	{
+		return;
+	}
+	while (channel.receive(m))
+	{
+		switch (m.type)
+		{
+		case MessageType::Start:
+			worker.start(m.a);
+			break;
+		case MessageType::Updates:
+			m.updates = worker.step(m.updates);
+			if (!channel.send(m))
+			{
+				return;
+			}
+			break;
+		case MessageType::Distances:
+			m.updates.clear();
+			for (int v = shard.first(); v < shard.first() + shard.vertices(); ++v)
+			{
+				m.updates.push_back(Update{ v, worker.distance(v) });
+			}
+			if (!channel.send(m))
+			{
+				return;
+			}
+			break;
+		default:
+			return;
+		}
+	}
+}
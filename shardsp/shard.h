@@ -0,0 +1,330 @@
+/*
+Edge-cut partitioning of a graph for the sharded shortest path solver.
+
+The vertices are split into shards of consecutive ids (ShardMap).  A shard
+holds the edges leaving its own vertices in CSR form, wherever their
+targets are; an edge to a vertex of another shard is a cut edge.  Each
+shard reads (or generates) only its own rows, so no process ever holds
+the whole graph.  Renumbering the graph first (reorder.h) keeps
+neighbors in the same shard and so cuts fewer edges.
+
+ShardWorker is one shard's part of a bulk synchronous SSSP, as in Pregel:
+	start(src) - reset the distances; the shard owning src seeds it
+	step(inbox) - apply the distance updates other shards sent for this
+	              shard's vertices, run Dijkstra over the shard's own
+	              edges from every vertex that improved and return the
+	              updates for the targets of the cut edges
+The search is over after a superstep that produces no updates.
+coordinate() drives the supersteps; how the updates travel is up to its
+caller, see channel.h for the one process per shard transport.
+*/
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../dijkstra/dijkstra.h"
+#include "../StaticLib1/random.h"
+
+// ShardMap ADT
+// Shard k owns the vertices [first(k), first(k + 1)).
+class ShardMap
+{
+private:
+	int m_size;
+	int m_shards;
+public:
+	ShardMap(int size, int shards)
+		: m_size(size), m_shards(std::max(1, std::min(shards, std::max(size, 1)))) {};
+	int vertices() const { return m_size; };
+	int shards() const { return m_shards; };
+	int first(int k) const { return static_cast<int>(static_cast<long long>(k) * m_size / m_shards); };
+	int count(int k) const { return first(k + 1) - first(k); };
+	// Largest k with first(k) <= v
+	int owner(int v) const
+	{
+		return static_cast<int>((static_cast<long long>(v + 1) * m_shards - 1) / m_size);
+	}
+};
+
+// Edges of shard k from a "size" then "i j c" per line file, as read by
+// mst; edges leaving other shards' vertices are skipped.
+inline std::vector<Edge> readShardEdges(const std::string& fname, const ShardMap& map, int k)
+{
+	std::vector<Edge> edges;
+	std::ifstream in(fname);
+	int size;
+	if (!(in >> size))
+	{
+		return edges;
+	}
+	int src, dst, cost;
+	while (in >> src >> dst >> cost)
+	{
+		if (src >= 0 && src < map.vertices() && map.owner(src) == k)
+		{
+			edges.push_back(Edge(src, dst, cost));
+		}
+	}
+	return edges;
+}
+
+// Vertex count of a graph file, -1 if it cannot be read
+inline int readGraphSize(const std::string& fname)
+{
+	std::ifstream in(fname);
+	int size;
+	return (in >> size) && size >= 0 ? size : -1;
+}
+
+// Random edges of shard k, as Graph::generate.  Row v is drawn from its
+// own stream of the seed, so every shard count gives the same graph.
+inline std::vector<Edge> generateShardEdges(const ShardMap& map, int k, double density,
+	std::uint64_t seed, int minCost = 1, int maxCost = 10)
+{
+	int size = map.vertices();
+	std::vector<Edge> edges;
+	edges.reserve(static_cast<std::size_t>(density * map.count(k) * size) + map.count(k));
+	std::vector<double> draws(size);
+	std::vector<int> costs(size);
+	for (int i = map.first(k); i < map.first(k + 1); ++i)
+	{
+		RandomStream rng(seed * 0x9E3779B97F4A7C15ull + i);
+		rng.fill(draws.data(), draws.size(), 0.0, 1.0);
+		rng.fill(costs.data(), costs.size(), minCost, maxCost);
+		for (int j = 0; j < size; ++j)
+		{
+			if (i != j && density > draws[j])
+			{
+				edges.push_back(Edge(i, j, costs[j]));
+			}
+		}
+	}
+	return edges;
+}
+
+// Shard ADT
+// Rows of the owned vertices, indexed by local id v - first; the targets
+// are global ids.
+class Shard
+{
+private:
+	ShardMap m_map;
+	int m_id;
+	int m_first;
+	int m_count;
+	std::vector<int> m_offsets;
+	std::vector<int> m_targets;
+	std::vector<int> m_costs;
+	int m_cutEdges;
+
+public:
+	Shard(const ShardMap& map, int id)
+		: m_map(map), m_id(id), m_first(map.first(id)), m_count(map.count(id)),
+		m_offsets(m_count + 1, 0), m_cutEdges(0) {};
+
+	const ShardMap& map() const { return m_map; };
+	int id() const { return m_id; };
+	int first() const { return m_first; };
+	int vertices() const { return m_count; };
+	bool owns(int v) const { return v >= m_first && v < m_first + m_count; };
+	int edges() const { return static_cast<int>(m_targets.size()); };
+	int cutEdges() const { return m_cutEdges; };
+	IdRange targets(int local) const
+	{
+		return IdRange(m_targets.data() + m_offsets[local], m_targets.data() + m_offsets[local + 1]);
+	}
+	IdRange costs(int local) const
+	{
+		return IdRange(m_costs.data() + m_offsets[local], m_costs.data() + m_offsets[local + 1]);
+	}
+
+	// Keep the edges leaving this shard's vertices.  As in Graph::build,
+	// self loops, out of range endpoints and duplicates (the first one
+	// wins) are dropped.
+	void build(std::vector<Edge> edges)
+	{
+		int size = m_map.vertices();
+		const Shard& self = *this;
+		edges.erase(std::remove_if(edges.begin(), edges.end(), [&self, size](const Edge& e)
+		{
+			return !self.owns(e.getSrc()) || e.getDst() < 0 || e.getDst() >= size ||
+				e.getSrc() == e.getDst();
+		}), edges.end());
+		std::stable_sort(edges.begin(), edges.end(), [](const Edge& e1, const Edge& e2)
+		{
+			return e1.getSrc() < e2.getSrc() ||
+				(e1.getSrc() == e2.getSrc() && e1.getDst() < e2.getDst());
+		});
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		std::fill(m_offsets.begin(), m_offsets.end(), 0);
+		m_targets.resize(edges.size());
+		m_costs.resize(edges.size());
+		m_cutEdges = 0;
+		for (std::size_t i = 0; i < edges.size(); ++i)
+		{
+			++m_offsets[edges[i].getSrc() - m_first + 1];
+			m_targets[i] = edges[i].getDst();
+			m_costs[i] = edges[i].getCost();
+			m_cutEdges += !owns(edges[i].getDst());
+		}
+		for (int v = 0; v < m_count; ++v)
+		{
+			m_offsets[v + 1] += m_offsets[v];
+		}
+	}
+};
+
+// A distance found for a vertex, sent to the shard owning it
+struct Update
+{
+	int vertex;
+	int distance;
+};
+
+// ShardWorker ADT
+class ShardWorker
+{
+private:
+	struct Sent
+	{
+		int distance;
+		int step;
+	};
+
+	const Shard& m_shard;
+	std::vector<int> m_distance;
+	PriorityQueue m_queue;
+	// Best distance reported so far for each cut edge target, so an
+	// update is only sent when it improves on the last one.
+	std::unordered_map<int, Sent> m_sent;
+	int m_step;
+
+	void relax(int local, int distance)
+	{
+		if (distance < m_distance[local])
+		{
+			m_distance[local] = distance;
+			m_queue.decrease(Set(local, distance));
+		}
+	}
+
+public:
+	explicit ShardWorker(const Shard& shard)
+		: m_shard(shard), m_distance(shard.vertices(), INT_MAX), m_step(0)
+	{
+		m_queue.reserve(shard.vertices());
+	};
+
+	void start(int src)
+	{
+		std::fill(m_distance.begin(), m_distance.end(), INT_MAX);
+		m_queue.clear();
+		m_sent.clear();
+		m_step = 0;
+		if (m_shard.owns(src))
+		{
+			relax(src - m_shard.first(), 0);
+		}
+	}
+
+	std::vector<Update> step(const std::vector<Update>& inbox)
+	{
+		++m_step;
+		for (auto& u : inbox)
+		{
+			if (m_shard.owns(u.vertex))
+			{
+				relax(u.vertex - m_shard.first(), u.distance);
+			}
+		}
+
+		std::vector<Update> outbox;
+		Set m(0, 0);
+		while (m_queue.pop(m))
+		{
+			IdRange targets = m_shard.targets(m.id());
+			IdRange costs = m_shard.costs(m.id());
+			for (int i = 0; i < targets.size(); ++i)
+			{
+				int n = targets[i];
+				int dist = m.cost() + costs[i];
+				if (m_shard.owns(n))
+				{
+					relax(n - m_shard.first(), dist);
+					continue;
+				}
+				auto it = m_sent.find(n);
+				if (it == m_sent.end())
+				{
+					m_sent.emplace(n, Sent{ dist, m_step });
+					outbox.push_back(Update{ n, dist });
+				}
+				else if (dist < it->second.distance)
+				{
+					it->second.distance = dist;
+					if (it->second.step != m_step)
+					{
+						it->second.step = m_step;
+						outbox.push_back(Update{ n, dist });
+					}
+				}
+			}
+		}
+		// A target may have improved again after it was queued for sending
+		for (auto& u : outbox)
+		{
+			u.distance = m_sent[u.vertex].distance;
+		}
+		return outbox;
+	}
+
+	// Distance of owned vertex v, INT_MAX if not reached
+	int distance(int v) const { return m_distance[v - m_shard.first()]; };
+	const std::vector<int>& distances() const { return m_distance; };
+};
+
+struct SearchStats
+{
+	int supersteps = 0;
+	std::size_t updates = 0;
+};
+
+// Run the supersteps of one search, after every shard was start()ed.
+// deliver(k, inbox) hands shard k its updates and collect(k) returns the
+// updates shard k produced from them.  All shards are delivered to before
+// any is collected from, so they can work at the same time.
+template <class Deliver, class Collect>
+SearchStats coordinate(const ShardMap& map, Deliver deliver, Collect collect)
+{
+	SearchStats stats;
+	std::vector<std::vector<Update>> inbox(map.shards());
+	for (;;)
+	{
+		for (int k = 0; k < map.shards(); ++k)
+		{
+			deliver(k, inbox[k]);
+			inbox[k].clear();
+		}
+		std::size_t updates = 0;
+		for (int k = 0; k < map.shards(); ++k)
+		{
+			for (auto& u : collect(k))
+			{
+				inbox[map.owner(u.vertex)].push_back(u);
+				++updates;
+			}
+		}
+		++stats.supersteps;
+		stats.updates += updates;
+		if (updates == 0)
+		{
+			return stats;
+		}
+	}
+}
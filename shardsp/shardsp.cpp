@@ -0,0 +1,267 @@
+// Need the following as the first include for a Visual Studio environment
+#include "stdafx.h"
+
+/*
+Sharded shortest paths over a partitioned graph.
+
+The graph is split into shards of consecutive vertex ids (shard.h) and
+every shard is served by its own worker process, forked from this one and
+connected to it by a Unix domain socket (channel.h).  A worker reads or
+generates only the edges of its own vertices.  This process coordinates
+the supersteps: it passes every worker its inbox of distance updates,
+collects the updates for other shards' vertices and routes them, until a
+superstep produces none.  Several processes on one box stand in for the
+nodes of a cluster; over TCP sockets the protocol would be the same.
+*/
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../StaticLib1/timer.h"
+#include "../dijkstra/graph.h"
+#include "shard.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "channel.h"
+#endif
+
+// Usage: shardsp [graphfile] [--generate size density] [--seed n]
+//                [--shards n] [--src s] [--dst d] [--check]
+// The graph is read from graphfile ("size" then "i j c" lines) or
+// generated; --shards sets the worker process count (default 4).  The
+// distance from src (default 0) to dst (default the last vertex) is
+// reported.  --check also solves the whole graph in this process and
+// compares every distance.
+int main(int argc, char **argv)
+{
+	Timer t;
+	std::string graphFile;
+	int generateSize{ 1000 };
+	double generateDensity{ 0.1 };
+	std::uint64_t seed{ 1 };
+	int shards{ 4 };
+	int src{ 0 };
+	int dst{ -1 };
+	bool check{ false };
+
+	for (int a = 1; a < argc; ++a)
+	{
+		std::string arg = argv[a];
+		if (arg == "--generate" && a + 2 < argc)
+		{
+			generateSize = std::atoi(argv[++a]);
+			generateDensity = std::atof(argv[++a]);
+		}
+		else if (arg == "--seed" && a + 1 < argc)
+		{
+			seed = std::strtoull(argv[++a], nullptr, 10);
+		}
+		else if (arg == "--shards" && a + 1 < argc)
+		{
+			shards = std::max(1, std::atoi(argv[++a]));
+		}
+		else if (arg == "--src" && a + 1 < argc)
+		{
+			src = std::atoi(argv[++a]);
+		}
+		else if (arg == "--dst" && a + 1 < argc)
+		{
+			dst = std::atoi(argv[++a]);
+		}
+		else if (arg == "--check")
+		{
+			check = true;
+		}
+		else
+		{
+			graphFile = arg;
+		}
+	}
+
+#ifdef _WIN32
+	std::cout << "shardsp forks its shard workers and needs a POSIX system" << std::endl;
+	return 1;
+#else
+	int size = graphFile.empty() ? generateSize : readGraphSize(graphFile);
+	if (size <= 0)
+	{
+		std::cout << "Unable to read " << graphFile << std::endl;
+		return 1;
+	}
+	if (dst < 0)
+	{
+		dst = size - 1;
+	}
+	if (src < 0 || src >= size || dst >= size)
+	{
+		std::cout << "Vertex out of range" << std::endl;
+		return 1;
+	}
+	ShardMap map(size, shards);
+	auto edgesOf = [&](const ShardMap& m, int k)
+	{
+		return graphFile.empty() ? generateShardEdges(m, k, generateDensity, seed) : readShardEdges(graphFile, m, k);
+	};
+
+	// Fork the workers; each one loads its shard and serves it
+	std::cout.flush();
+	std::vector<Channel> channels;
+	std::vector<pid_t> workers;
+	for (int k = 0; k < map.shards(); ++k)
+	{
+		int fds[2];
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+		{
+			std::cout << "Unable to create a socket pair" << std::endl;
+			return 1;
+		}
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			// The child keeps only its own end
+			channels.clear();
+			::close(fds[0]);
+			Channel channel(fds[1]);
+			Shard shard(map, k);
+			shard.build(edgesOf(map, k));
+			serveShard(channel, shard);
+			std::exit(0);
+		}
+		::close(fds[1]);
+		if (pid < 0)
+		{
+			::close(fds[0]);
+			std::cout << "Unable to start worker " << k << std::endl;
+			return 1;
+		}
+		channels.emplace_back(fds[0]);
+		workers.push_back(pid);
+	}
+
+	bool ok = true;
+	long long edges = 0;
+	long long cutEdges = 0;
+	Message m;
+	for (auto& c : channels)
+	{
+		ok = c.receive(m) && m.type == MessageType::Ready && ok;
+		edges += m.a;
+		cutEdges += m.b;
+	}
+	std::cout << "Graph: " << size << " vertices, " << edges << " edges in " << map.shards();
+	std::cout << " shards, " << cutEdges << " cut edges\n";
+
+	Timer st;
+	Message start;
+	start.type = MessageType::Start;
+	start.a = src;
+	for (auto& c : channels)
+	{
+		ok = c.send(start) && ok;
+	}
+	SearchStats stats = coordinate(map,
+		[&](int k, const std::vector<Update>& inbox)
+	{
+		Message u;
+		u.type = MessageType::Updates;
+		u.updates = inbox;
+		ok = channels[k].send(u) && ok;
+	},
+		[&](int k)
+	{
+		Message u;
+		ok = channels[k].receive(u) && ok;
+		return u.updates;
+	});
+
+	// Gather the distances from the shards
+	std::vector<int> distance(size, INT_MAX);
+	Message request;
+	request.type = MessageType::Distances;
+	for (auto& c : channels)
+	{
+		ok = c.send(request) && ok;
+	}
+	for (auto& c : channels)
+	{
+		ok = c.receive(m) && ok;
+		for (auto& u : m.updates)
+		{
+			if (u.vertex >= 0 && u.vertex < size)
+			{
+				distance[u.vertex] = u.distance;
+			}
+		}
+	}
+	double searchTime = st.elapsed();
+
+	std::size_t bytes = 0;
+	Message quit;
+	quit.type = MessageType::Quit;
+	for (auto& c : channels)
+	{
+		c.send(quit);
+		bytes += c.bytesSent();
+	}
+	channels.clear();
+	for (pid_t w : workers)
+	{
+		int status = 0;
+		waitpid(w, &status, 0);
+		ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	}
+	if (!ok)
+	{
+		std::cout << "A shard worker failed" << std::endl;
+		return 1;
+	}
+
+	if (distance[dst] == INT_MAX)
+	{
+		std::cout << "No path from " << src << " to " << dst << '\n';
+	}
+	else
+	{
+		std::cout << "Path cost from " << src << " to " << dst << ": " << distance[dst] << '\n';
+	}
+	std::cout << "Supersteps: " << stats.supersteps << ", updates exchanged: " << stats.updates;
+	std::cout << ", coordinator bytes sent: " << bytes << '\n';
+	std::cout << "Search time: " << searchTime << '\n';
+
+	if (check)
+	{
+		// The whole graph as one shard, solved in this process
+		ShardMap whole(size, 1);
+		graph::Graph<int, true, graph::Dense> g(size);
+		Shard all(whole, 0);
+		all.build(edgesOf(whole, 0));
+		for (int v = 0; v < size; ++v)
+		{
+			IdRange targets = all.targets(v);
+			IdRange costs = all.costs(v);
+			for (int i = 0; i < targets.size(); ++i)
+			{
+				g.addEdge(v, targets[i], costs[i]);
+			}
+		}
+		auto expected = graph::shortestDistances(g, src);
+		int mismatches = 0;
+		for (int v = 0; v < size; ++v)
+		{
+			mismatches += expected[v] != distance[v];
+		}
+		std::cout << "Check: " << mismatches << " of " << size << " distances differ\n";
+	}
+	std::cout << "Total processing time: " << t.elapsed() << std::endl;
+	return 0;
+#endif
+}